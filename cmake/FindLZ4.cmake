@@ -0,0 +1,29 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+# Try to find lz4
+# This will define the following variables:
+#
+# ``LZ4_FOUND``
+#     True if lz4 is available
+# ``LZ4_VERSION``
+#     The version of lz4
+#
+# and the imported target ``LZ4::lz4``
+
+find_package(PkgConfig QUIET)
+pkg_check_modules(LZ4 QUIET IMPORTED_TARGET GLOBAL liblz4)
+
+if(TARGET PkgConfig::LZ4)
+    add_library(LZ4::lz4 ALIAS PkgConfig::LZ4)
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LZ4
+    REQUIRED_VARS
+        LZ4_FOUND
+    VERSION_VAR
+        LZ4_VERSION
+)
+
+mark_as_advanced(LZ4_VERSION)
@@ -0,0 +1,29 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+# Try to find zstd
+# This will define the following variables:
+#
+# ``Zstd_FOUND``
+#     True if zstd is available
+# ``Zstd_VERSION``
+#     The version of zstd
+#
+# and the imported target ``Zstd::zstd``
+
+find_package(PkgConfig QUIET)
+pkg_check_modules(Zstd QUIET IMPORTED_TARGET GLOBAL libzstd)
+
+if(TARGET PkgConfig::Zstd)
+    add_library(Zstd::zstd ALIAS PkgConfig::Zstd)
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd
+    REQUIRED_VARS
+        Zstd_FOUND
+    VERSION_VAR
+        Zstd_VERSION
+)
+
+mark_as_advanced(Zstd_VERSION)
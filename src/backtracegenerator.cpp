@@ -9,6 +9,10 @@
  *****************************************************************/
 #include "backtracegenerator.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "config-drkonqi.h"
 #include "drkonqi.h"
 #include "drkonqi_debug.h"
@@ -23,7 +27,9 @@
 #include <KOSRelease>
 #include <KProcess>
 #include <KShell>
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
 
 #include "crashedapplication.h"
 #include "parser/backtraceparser.h"
@@ -85,9 +91,13 @@ BacktraceGenerator::BacktraceGenerator(const Debugger &debugger, QObject *parent
         lock->setStaleLockTime(10min); // debugging can take a good while
         return lock;
     }())
+    , m_systemFacts(new SystemFacts(SystemFacts::Config(), this))
 {
     m_parser = BacktraceParser::newParser(m_debugger.codeName(), this);
     m_parser->connectToGenerator(this);
+
+    // Gather ahead of time so the facts are ready by the time the debugger starts. Usually they come out of the cache anyway.
+    m_systemFacts->gather();
 }
 
 BacktraceGenerator::~BacktraceGenerator()
@@ -106,6 +116,7 @@ BacktraceGenerator::~BacktraceGenerator()
         }
         delete m_temp;
     }
+    closeCoreReadyFifo();
     if (m_lockFile) {
         m_lockFile->unlock();
         delete m_lockFile;
@@ -130,6 +141,7 @@ void BacktraceGenerator::start()
 
     m_state = Loading;
     Q_EMIT stateChanged();
+    m_timer.start();
     Q_EMIT preparing();
     // DebuggerManager calls setBackendPrepared when it is ready for us to actually start.
 }
@@ -182,6 +194,7 @@ void BacktraceGenerator::resetProcessAndUnlock()
         m_temp->deleteLater();
         m_temp = nullptr;
     }
+    closeCoreReadyFifo();
     if (m_lockFile) {
         m_lockFile->unlock();
     }
@@ -189,6 +202,8 @@ void BacktraceGenerator::resetProcessAndUnlock()
 
 void BacktraceGenerator::slotProcessExited(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    qCDebug(DRKONQI_LOG) << "Debugger finished" << m_timer.elapsed() << "ms after preparing started, pipelined:" << (m_coreReadyFd >= 0);
+
     // the process is useless now
     resetProcessAndUnlock();
 
@@ -269,10 +284,85 @@ void BacktraceGenerator::slotOnErrorOccurred(QProcess::ProcessError error)
     }
 }
 
-void BacktraceGenerator::setBackendPrepared()
+bool BacktraceGenerator::openCoreReadyFifo()
+{
+    if (!m_tempDirectory) {
+        m_tempDirectory = std::make_unique<QTemporaryDir>();
+    }
+    if (!m_tempDirectory->isValid()) {
+        return false;
+    }
+
+    m_coreReadyFifo = m_tempDirectory->filePath(u"core-ready"_s);
+    const auto path = QFile::encodeName(m_coreReadyFifo);
+    if (mkfifo(path.constData(), 0600) != 0) {
+        qCWarning(DRKONQI_LOG) << "Failed to create core fifo" << m_coreReadyFifo << strerror(errno);
+        m_coreReadyFifo.clear();
+        return false;
+    }
+    // O_RDWR on a fifo doesn't wait for a reader (Linux specific but so are we).
+    m_coreReadyFd = open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_coreReadyFd < 0) {
+        qCWarning(DRKONQI_LOG) << "Failed to open core fifo" << m_coreReadyFifo << strerror(errno);
+        closeCoreReadyFifo();
+        return false;
+    }
+    return true;
+}
+
+void BacktraceGenerator::signalCore(QByteArrayView status)
+{
+    Q_ASSERT(m_coreReadyFd >= 0);
+    // Tiny and the fifo is otherwise empty, this can't block or come out short.
+    if (write(m_coreReadyFd, status.data(), status.size()) != status.size()) {
+        qCWarning(DRKONQI_LOG) << "Failed to signal core status" << strerror(errno);
+    }
+}
+
+void BacktraceGenerator::closeCoreReadyFifo()
+{
+    // Must stay open until the debugger is done. Once the last reference is gone the kernel discards unread data.
+    if (m_coreReadyFd >= 0) {
+        close(m_coreReadyFd);
+        m_coreReadyFd = -1;
+    }
+    if (!m_coreReadyFifo.isEmpty()) {
+        QFile::remove(m_coreReadyFifo);
+        m_coreReadyFifo.clear();
+    }
+}
+
+void BacktraceGenerator::setBackendPipelined()
 {
     Q_ASSERT(m_state == Loading);
 
+    // Unsupported or no fifo -> we simply start once the backend is prepared.
+    if (!m_debugger.supportsPipelinedCore() || !openCoreReadyFifo()) {
+        return;
+    }
+
+    // Python, the preamble and the executable's symbols load while the core is excavated. The debugger then waits on
+    // the fifo before loading the core.
+    qCDebug(DRKONQI_LOG) << "Starting debugger ahead of the core";
+    acquireLockAndStartProcess();
+}
+
+void BacktraceGenerator::setBackendPrepared()
+{
+    if (m_state != Loading) { // pipelined and the debugger already gave up waiting on the core
+        return;
+    }
+
+    if (m_coreReadyFd >= 0) {
+        qCDebug(DRKONQI_LOG) << "Core ready" << m_timer.elapsed() << "ms after preparing started, the debugger was started ahead of it";
+        signalCore("ready\n");
+        return;
+    }
+    acquireLockAndStartProcess();
+}
+
+void BacktraceGenerator::acquireLockAndStartProcess()
+{
     if (!m_lockFile) {
         qCDebug(DRKONQI_LOG) << "No lock file. Starting without lock.";
         startProcess();
@@ -298,6 +388,10 @@ void BacktraceGenerator::setBackendPrepared()
             qCDebug(DRKONQI_LOG) << "Delayed lock acquired";
             m_lockWatcher->deleteLater();
             m_lockWatcher = nullptr;
+            if (m_state != Loading) { // pipelined and the backend failed to prepare meanwhile
+                m_lockFile->unlock();
+                return;
+            }
             startProcess();
         });
 
@@ -337,6 +431,10 @@ void BacktraceGenerator::startProcess()
 
 void BacktraceGenerator::startProcessInternal()
 {
+    if (m_state != Loading) { // pipelined and the backend failed to prepare meanwhile
+        return;
+    }
+
     m_proc = new KProcess;
     m_proc->setEnv(QStringLiteral("LC_ALL"), QStringLiteral("C.UTF-8")); // force C locale
 
@@ -345,6 +443,12 @@ void BacktraceGenerator::startProcessInternal()
         m_proc->setEnv(key, value);
     }
 
+    // When the facts aren't ready yet the preamble falls back to running drkonqi-sentry-data.
+    const auto factsEnvironment = m_systemFacts->environment();
+    for (const auto &[key, value] : factsEnvironment.asKeyValueRange()) {
+        m_proc->setEnv(key, value);
+    }
+
     // Temporary directory for the preamble.py to write data into, we can then conveniently pick it up from there.
     // Only useful for data that is not meant to appear in the trace (e.g. sentry payloads).
     if (!m_tempDirectory) {
@@ -369,6 +473,14 @@ void BacktraceGenerator::startProcessInternal()
         m_proc->setEnv(QStringLiteral("DRKONQI_APP_VERSION"), DrKonqi::appVersion());
         m_proc->setEnv(QStringLiteral("DRKONQI_SIGNAL"), QString::number(DrKonqi::signal()));
         m_proc->setEnv(u"DRKONQI_COREFILE"_s, DrKonqi::crashedApplication()->m_coreFile);
+        if (m_coreReadyFd >= 0) {
+            m_proc->setEnv(u"DRKONQI_CORE_READY_FIFO"_s, m_coreReadyFifo);
+        }
+        if (!DrKonqi::crashedApplication()->m_moduleTableFile.isEmpty()) {
+            m_proc->setEnv(u"DRKONQI_MODULE_TABLE"_s, DrKonqi::crashedApplication()->m_moduleTableFile);
+        }
+        m_proc->setEnv(u"DRKONQI_THREAD_SAMPLING_THRESHOLD"_s, QString::number(Settings::threadSamplingThreshold()));
+        m_proc->setEnv(u"DRKONQI_THREAD_SAMPLING_FRAMES"_s, QString::number(Settings::threadSamplingFrames()));
         if (!DrKonqi::crashedApplication()->m_crashingThreadName.isEmpty()) {
             m_proc->setEnv(u"DRKONQI_CRASHING_THREAD_NAME"_s, DrKonqi::crashedApplication()->m_crashingThreadName);
         }
@@ -387,7 +499,12 @@ void BacktraceGenerator::startProcessInternal()
     preamble->flush();
 
     // start the debugger
-    QString str = m_symbolResolution ? m_debugger.commandWithSymbolResolution() : m_debugger.command();
+    QString str = [this] {
+        if (m_coreReadyFd >= 0) {
+            return m_symbolResolution ? m_debugger.pipelinedCommandWithSymbolResolution() : m_debugger.pipelinedCommand();
+        }
+        return m_symbolResolution ? m_debugger.commandWithSymbolResolution() : m_debugger.command();
+    }();
     Debugger::expandString(str, Debugger::ExpansionUsageShell, m_temp->fileName(), preamble->fileName());
 
     *m_proc << KShell::splitArgs(str);
@@ -476,6 +593,15 @@ QByteArray BacktraceGenerator::sentryPayload() const
 
 void BacktraceGenerator::setBackendFailedToPrepare(const QString &context)
 {
+    if (m_coreReadyFd >= 0) {
+        // Pipelined, the debugger is already (about to be) running and waiting for a core that won't come.
+        if (m_proc) {
+            m_proc->disconnect(this);
+            m_proc->kill();
+        }
+        resetProcessAndUnlock();
+    }
+
     // Shouldn't have been set yet
     Q_ASSERT(!m_proc);
     Q_ASSERT(!m_temp);
@@ -12,6 +12,7 @@
 
 #include <memory>
 
+#include <QElapsedTimer>
 #include <QFutureWatcher>
 #include <QProcess>
 #include <QQmlEngine>
@@ -22,6 +23,7 @@
 #include "debuggermanager.h"
 #include "drkonqi.h"
 #include "systemd/memoryfence.h"
+#include "systemd/systemfacts.h"
 
 class KProcess;
 class BacktraceParser;
@@ -76,6 +78,8 @@ public:
         return m_parsedBacktrace;
     }
 
+    // Called by manager when we may start ahead of the core (only some debuggers can).
+    void setBackendPipelined();
     // Called by manager when it is ready for us.
     void setBackendPrepared();
     // ... or not
@@ -110,6 +114,10 @@ private Q_SLOTS:
 
 private:
     void resetProcessAndUnlock();
+    void acquireLockAndStartProcess();
+    [[nodiscard]] bool openCoreReadyFifo();
+    void signalCore(QByteArrayView status);
+    void closeCoreReadyFifo();
     void startProcess();
     void startProcessInternal();
     void memoryConstrainProc();
@@ -129,6 +137,12 @@ private:
     QLockFile *m_lockFile;
     QFutureWatcher<bool> *m_lockWatcher = nullptr;
     bool m_crampedMemory = false;
+    SystemFacts *m_systemFacts = nullptr;
+    // Pipelining: the debugger reads the core's status from the fifo. We hold it open read-write so writes never
+    // block and the debugger sees EOF should we go away.
+    int m_coreReadyFd = -1;
+    QString m_coreReadyFifo;
+    QElapsedTimer m_timer;
 };
 
 #endif
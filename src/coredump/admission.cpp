@@ -0,0 +1,196 @@
+/*
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include "admission.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QScopeGuard>
+#include <QStandardPaths>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr auto TOKENS_KEY = "tokens"_L1;
+constexpr auto UPDATED_KEY = "updated"_L1;
+constexpr auto SUPPRESSED_KEY = "suppressed"_L1;
+constexpr auto CRASH_KEY = "crash"_L1;
+
+// What is needed to report a storm. Not the entire crash, some fields are huge (e.g. COREDUMP_PROC_MAPS).
+[[nodiscard]] QList<QByteArray> reportedFields()
+{
+    return {
+        "COREDUMP_EXE"_ba,
+        "COREDUMP_PID"_ba,
+        "COREDUMP_SIGNAL"_ba,
+        "COREDUMP_UNIT"_ba,
+        "COREDUMP_USER_UNIT"_ba,
+        "COREDUMP_TIMESTAMP"_ba,
+        "_BOOT_ID"_ba,
+        Coredump::keyFilename(),
+        Coredump::keyCursor(),
+    };
+}
+
+[[nodiscard]] QJsonObject fieldsToJson(const Coredump &dump)
+{
+    QJsonObject object;
+    for (const auto &key : reportedFields()) {
+        if (const auto it = dump.m_rawData.constFind(key); it != dump.m_rawData.cend()) {
+            object.insert(QString::fromUtf8(key), QString::fromUtf8(it.value()));
+        }
+    }
+    return object;
+}
+
+[[nodiscard]] Coredump::EntriesHash jsonToFields(const QJsonObject &object)
+{
+    Coredump::EntriesHash fields;
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        fields.insert(it.key().toUtf8(), it.value().toString().toUtf8());
+    }
+    return fields;
+}
+} // namespace
+
+Admission::Admission(QString statePath, Config config)
+    : m_statePath(std::move(statePath))
+    , m_config(config)
+{
+}
+
+Admission::Decision Admission::admit(const Coredump &dump, std::chrono::system_clock::time_point now)
+{
+    return update(&dump, now).value_or(Decision()); // fail open, better too many crashes than none
+}
+
+QList<Admission::Suppressed> Admission::expire(std::chrono::system_clock::time_point now)
+{
+    if (const auto decision = update(nullptr, now); decision.has_value()) {
+        return decision->suppressed;
+    }
+    return {};
+}
+
+void Admission::refill(QJsonObject &bucket, qint64 nowSecs) const
+{
+    const auto tokens = bucket.value(TOKENS_KEY).toDouble(m_config.burst);
+    const auto updated = bucket.value(UPDATED_KEY).toInteger(nowSecs);
+    const auto refilled = double(std::max<qint64>(nowSecs - updated, 0)) / double(m_config.refillInterval.count());
+    bucket.insert(TOKENS_KEY, std::min<double>(m_config.burst, tokens + refilled));
+    bucket.insert(UPDATED_KEY, nowSecs);
+}
+
+std::optional<Admission::Decision> Admission::update(const Coredump *dump, std::chrono::system_clock::time_point now)
+{
+    // Never follow links, nor block on something that isn't a plain file.
+    const int fd = open(QFile::encodeName(m_statePath).constData(), O_RDWR | O_CREAT | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        qWarning() << "Failed to open admission state" << m_statePath << strerror(errno);
+        return std::nullopt;
+    }
+    const auto closeFd = qScopeGuard([fd] {
+        close(fd);
+    });
+    if (struct stat info{}; fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        qWarning() << "Admission state is not a regular file" << m_statePath;
+        return std::nullopt;
+    }
+    if (flock(fd, LOCK_EX) != 0) {
+        qWarning() << "Failed to lock admission state" << m_statePath << strerror(errno);
+        return std::nullopt;
+    }
+
+    QFile file;
+    if (!file.open(fd, QFile::ReadWrite, QFile::DontCloseHandle)) {
+        return std::nullopt;
+    }
+    auto state = QJsonDocument::fromJson(file.readAll()).object();
+
+    Decision decision;
+    const auto nowSecs = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    const auto dumpKey = dump ? QString::fromUtf8(keyFor(*dump)) : QString();
+    for (auto it = state.begin(); it != state.end();) {
+        if (it.key() == dumpKey) { // the storm of the crash at hand ends with it, see below
+            ++it;
+            continue;
+        }
+        auto bucket = it.value().toObject();
+        const bool forgotten = nowSecs - bucket.value(UPDATED_KEY).toInteger() > m_config.forgetAfter.count();
+        // Only look at what the tokens would be, the refill is only written when a crash comes in.
+        auto refilled = bucket;
+        refill(refilled, nowSecs);
+        if (const auto suppressed = bucket.value(SUPPRESSED_KEY).toInt(0);
+            suppressed > 0 && (forgotten || refilled.value(TOKENS_KEY).toDouble() >= 1)) {
+            decision.suppressed.append(Suppressed{.fields = jsonToFields(bucket.value(CRASH_KEY).toObject()), .count = suppressed});
+            bucket.remove(SUPPRESSED_KEY);
+            bucket.remove(CRASH_KEY);
+            it.value() = bucket;
+        }
+        if (forgotten) {
+            it = state.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (dump) {
+        auto bucket = state.value(dumpKey).toObject();
+        if (nowSecs - bucket.value(UPDATED_KEY).toInteger(nowSecs) > m_config.forgetAfter.count()) {
+            // Start afresh, the crash still carries whatever storm was left over.
+            bucket.remove(TOKENS_KEY);
+            bucket.remove(UPDATED_KEY);
+        }
+        refill(bucket, nowSecs);
+        auto tokens = bucket.value(TOKENS_KEY).toDouble();
+        if (tokens >= 1) {
+            bucket.insert(TOKENS_KEY, tokens - 1);
+            decision.stormCount = bucket.value(SUPPRESSED_KEY).toInt(0);
+            bucket.remove(SUPPRESSED_KEY);
+            bucket.remove(CRASH_KEY);
+        } else {
+            const auto suppressed = bucket.value(SUPPRESSED_KEY).toInt(0) + 1;
+            decision.admitted = false;
+            bucket.insert(SUPPRESSED_KEY, suppressed);
+            bucket.insert(CRASH_KEY, fieldsToJson(*dump));
+            if (suppressed == 1) {
+                // Suppressed crashes don't take tokens, so the storm is over once the tokens have refilled.
+                // Plus a second so rounding can't have us look a tad too early.
+                const auto remaining = std::chrono::seconds(qint64(std::ceil((1 - tokens) * double(m_config.refillInterval.count()))));
+                decision.expiry = now + remaining + std::chrono::seconds(1);
+            }
+        }
+        state.insert(dumpKey, bucket);
+    }
+
+    const auto data = QJsonDocument(state).toJson(QJsonDocument::Compact);
+    if (!file.seek(0) || file.write(data) != data.size() || !file.resize(data.size())) {
+        qWarning() << "Failed to write admission state" << m_statePath << file.errorString();
+    }
+    return decision;
+}
+
+QByteArray Admission::keyFor(const Coredump &dump)
+{
+    // Per executable. Whether it crashes the same way every time or not, a crash loop is a crash loop.
+    return dump.exe.toUtf8();
+}
+
+QString Admission::statePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/drkonqi-coredump-admission.json"_L1;
+}
@@ -0,0 +1,72 @@
+/*
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include "coredump.h"
+
+// Crash storm admission control. When something crash-loops we'd otherwise spawn a drkonqi or a notification for
+// every single crash. Instead every executable gets a token bucket.
+// Crashes that find the bucket empty are not handled but counted. Once the bucket has refilled the storm is over. The
+// next admitted crash of the executable carries the count, should there be none the count gets reported alongside the
+// most recent crash of the storm by whoever checks next.
+// Used by the launcher, as the crashed user. The state is kept in the runtime dir so it gets thrown away on logout.
+class Admission
+{
+public:
+    struct Config {
+        // How many crashes of an executable may be handled in a row. A couple, an app that crashes again after being
+        // restarted still deserves a report.
+        int burst = 3;
+        // One more crash may be handled after this long
+        std::chrono::seconds refillInterval = std::chrono::minutes(1);
+        // Buckets that haven't been touched in this long are dropped
+        std::chrono::seconds forgetAfter = std::chrono::hours(1);
+    };
+
+    // A storm that is over
+    struct Suppressed {
+        // Fields of the most recent crash that wasn't admitted
+        Coredump::EntriesHash fields;
+        // How many crashes weren't admitted
+        int count = 0;
+    };
+
+    struct Decision {
+        bool admitted = true;
+        // Set when the crash started a storm. A caller that is around anyway may expire() by then so the storm gets
+        // reported even when nothing else crashes.
+        std::optional<std::chrono::system_clock::time_point> expiry;
+        // Storms of other executables that were over by the time of this decision
+        QList<Suppressed> suppressed;
+        // Crashes of the same executable that weren't admitted before this one. Only set when admitted, the crash then
+        // stands for stormCount + 1 crashes.
+        int stormCount = 0;
+    };
+
+    explicit Admission(QString statePath = statePath(), Config config = Config());
+
+    [[nodiscard]] Decision admit(const Coredump &dump, std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+    // Collects the storms that are over.
+    [[nodiscard]] QList<Suppressed> expire(std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+
+    [[nodiscard]] static QByteArray keyFor(const Coredump &dump);
+    [[nodiscard]] static QString statePath();
+
+private:
+    [[nodiscard]] std::optional<Decision> update(const Coredump *dump, std::chrono::system_clock::time_point now);
+    void refill(QJsonObject &bucket, qint64 nowSecs) const;
+
+    const QString m_statePath;
+    const Config m_config;
+};
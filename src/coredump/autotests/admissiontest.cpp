@@ -0,0 +1,190 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <sys/stat.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <admission.h>
+#include <coredump.h>
+
+using namespace std::chrono_literals;
+using namespace Qt::StringLiterals;
+
+namespace
+{
+[[nodiscard]] Coredump makeDump(const QByteArray &exe, int pid = 1)
+{
+    return {QByteArray(), {{"COREDUMP_EXE"_ba, exe}, {"COREDUMP_PID"_ba, QByteArray::number(pid)}, {"COREDUMP_SIGNAL"_ba, "11"_ba}}};
+}
+} // namespace
+
+class AdmissionTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBurstThenSuppress()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        Admission admission(path, {.burst = 2, .refillInterval = 60s, .forgetAfter = 1h});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        const auto first = admission.admit(makeDump("/usr/bin/foo"_ba), now);
+        QVERIFY(!first.admitted);
+        QVERIFY(first.expiry == now + 61s);
+        const auto second = admission.admit(makeDump("/usr/bin/foo"_ba), now + 1s);
+        QVERIFY(!second.admitted);
+        QVERIFY(!second.expiry.has_value()); // the storm is already underway
+        // Other executables are not affected
+        QVERIFY(admission.admit(makeDump("/usr/bin/bar"_ba), now).admitted);
+    }
+
+    void testDefaultBurst()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        // A second crash, e.g. after the app got restarted, still gets handled.
+        Admission admission(path);
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+    }
+
+    void testStormThenSilence()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        Admission admission(path, {.burst = 1, .refillInterval = 60s, .forgetAfter = 1h});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba, 1), now).admitted);
+        const auto decision = admission.admit(makeDump("/usr/bin/foo"_ba, 2), now + 1s);
+        QVERIFY(!decision.admitted);
+        QVERIFY(decision.expiry.has_value());
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba, 3), now + 2s).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba, 4), now + 3s).admitted);
+
+        // Nothing is over while the bucket is still empty
+        QVERIFY(admission.expire(now + 30s).isEmpty());
+
+        // Then nothing crashes any more. The storm gets reported once, with the most recent crash.
+        const auto suppressed = admission.expire(decision.expiry.value());
+        QCOMPARE(suppressed.size(), 1);
+        QCOMPARE(suppressed.constFirst().count, 3);
+        QCOMPARE(suppressed.constFirst().fields.value("COREDUMP_EXE"_ba), "/usr/bin/foo"_ba);
+        QCOMPARE(suppressed.constFirst().fields.value("COREDUMP_PID"_ba), "4"_ba);
+        QVERIFY(admission.expire(decision.expiry.value() + 1s).isEmpty());
+
+        // And the next crash is handled as usual
+        const auto next = admission.admit(makeDump("/usr/bin/foo"_ba, 5), decision.expiry.value() + 2s);
+        QVERIFY(next.admitted);
+        QVERIFY(next.suppressed.isEmpty());
+        QCOMPARE(next.stormCount, 0);
+    }
+
+    void testStormEndsWithNextCrash()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        Admission admission(path, {.burst = 1, .refillInterval = 60s, .forgetAfter = 1h});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba, 1), now).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba, 2), now + 1s).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba, 3), now + 2s).admitted);
+
+        // The next admitted crash of the executable carries the storm, it isn't reported on its own.
+        const auto decision = admission.admit(makeDump("/usr/bin/foo"_ba, 4), now + 2min);
+        QVERIFY(decision.admitted);
+        QVERIFY(decision.suppressed.isEmpty());
+        QCOMPARE(decision.stormCount, 2);
+        QVERIFY(admission.expire(now + 3min).isEmpty());
+    }
+
+    void testExpireOnAnyAdmission()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        Admission admission(path, {.burst = 1, .refillInterval = 60s, .forgetAfter = 1h});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+
+        // Whoever checks next reports storms that are over, regardless of what crashed.
+        const auto decision = admission.admit(makeDump("/usr/bin/bar"_ba), now + 2min);
+        QVERIFY(decision.admitted);
+        QCOMPARE(decision.suppressed.size(), 1);
+        QCOMPARE(decision.suppressed.constFirst().count, 1);
+        QCOMPARE(decision.stormCount, 0);
+    }
+
+    void testStateIsShared()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        QVERIFY(Admission(path, {.burst = 1}).admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(!Admission(path, {.burst = 1}).admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+    }
+
+    void testForget()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        const std::chrono::system_clock::time_point now(1000h);
+
+        Admission admission(path, {.burst = 1, .refillInterval = 24h, .forgetAfter = 1h});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        QVERIFY(!admission.admit(makeDump("/usr/bin/foo"_ba), now).admitted);
+        const auto decision = admission.admit(makeDump("/usr/bin/foo"_ba), now + 2h);
+        QVERIFY(decision.admitted); // a forgotten bucket starts afresh
+        QCOMPARE(decision.stormCount, 1); // forgotten storms still get reported
+    }
+
+    void testRefusesNonRegularState()
+    {
+        QTemporaryDir dir;
+        const auto path = dir.filePath(u"state.json"_s);
+        QCOMPARE(mkfifo(QFile::encodeName(path).constData(), 0600), 0);
+
+        // Must neither block on the fifo nor stop crashes from being handled.
+        Admission admission(path, {.burst = 1});
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba)).admitted);
+        QVERIFY(admission.admit(makeDump("/usr/bin/foo"_ba)).admitted);
+    }
+
+    void testKey()
+    {
+        const Coredump dump(QByteArray(),
+                            {
+                                {"COREDUMP_EXE"_ba, "/usr/bin/foo"_ba},
+                                {"COREDUMP_SIGNAL"_ba, "11"_ba},
+                                {"COREDUMP_PACKAGE_JSON"_ba, R"({"/usr/bin/foo":{"buildId":"abcdef"}})"_ba},
+                            });
+        QCOMPARE(Admission::keyFor(dump), "/usr/bin/foo"_ba);
+    }
+
+    void testCrashCount()
+    {
+        const Coredump plain(QByteArray(), {{"COREDUMP_EXE"_ba, "/usr/bin/foo"_ba}});
+        QCOMPARE(plain.crashCount, 1);
+        const Coredump counted(QByteArray(), {{"COREDUMP_EXE"_ba, "/usr/bin/foo"_ba}, {Coredump::keyCrashCount(), "4"_ba}});
+        QCOMPARE(counted.crashCount, 4);
+    }
+};
+
+QTEST_GUILESS_MAIN(AdmissionTest)
+
+#include "admissiontest.moc"
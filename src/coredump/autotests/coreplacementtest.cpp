@@ -0,0 +1,49 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QTest>
+
+#include <coreplacement.h>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr quint64 GiB = 1024ULL * 1024 * 1024;
+// Plenty of runtime space, so only the free RAM matters.
+constexpr quint64 RUNTIME_FREE = 1024 * GiB;
+} // namespace
+
+class CorePlacementTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testUnknown()
+    {
+        QCOMPARE(CorePlacement::choose(std::nullopt, 64 * GiB, RUNTIME_FREE), CorePlacement::Target::Disk);
+        QCOMPARE(CorePlacement::choose(GiB, std::nullopt, RUNTIME_FREE), CorePlacement::Target::Disk);
+        QCOMPARE(CorePlacement::choose(GiB, 64 * GiB, std::nullopt), CorePlacement::Target::Disk);
+    }
+
+    void testSpaciousBoundary()
+    {
+        // What is left after placing the core must keep MemoryFence in the spacious tier: more than 12 GiB once it
+        // took away its 1 GiB of breathing room.
+        QCOMPARE(CorePlacement::choose(GiB, 15 * GiB, RUNTIME_FREE), CorePlacement::Target::Memory);
+        QCOMPARE(CorePlacement::choose(GiB, 15 * GiB - 1, RUNTIME_FREE), CorePlacement::Target::Disk);
+        QCOMPARE(CorePlacement::choose(GiB, 14 * GiB, RUNTIME_FREE), CorePlacement::Target::Disk);
+        QCOMPARE(CorePlacement::choose(32 * GiB, 16 * GiB, RUNTIME_FREE), CorePlacement::Target::Disk);
+    }
+
+    void testRuntimeShare()
+    {
+        QCOMPARE(CorePlacement::choose(GiB, 64 * GiB, 2 * GiB), CorePlacement::Target::Memory);
+        QCOMPARE(CorePlacement::choose(GiB, 64 * GiB, 2 * GiB - 1), CorePlacement::Target::Disk);
+    }
+};
+
+QTEST_GUILESS_MAIN(CorePlacementTest)
+
+#include "coreplacementtest.moc"
@@ -0,0 +1,83 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <KSycoca>
+
+#include <serviceindex.h>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+void writeDesktopFile(const QString &name, const QByteArray &extraLines = {})
+{
+    const auto dir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications"_L1;
+    QDir().mkpath(dir);
+    QFile file(dir + u'/' + name + ".desktop"_L1);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write("[Desktop Entry]\nType=Application\nName=" + name.toUtf8() + "\nIcon=" + name.toUtf8() + '\n' + extraLines);
+}
+} // namespace
+
+class ServiceIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QFile::remove(ServiceIndex::path());
+        writeDesktopFile(u"org.kde.konqi"_s, "Exec=/usr/bin/konqi %u\n");
+        writeDesktopFile(u"org.kde.terminal"_s, "Exec=terminal\nCategories=System;TerminalEmulator;\n");
+        KSycoca::setupTestMenu();
+        KSycoca::self()->ensureCacheValid();
+    }
+
+    void testExecutable()
+    {
+        ServiceIndex index;
+        const auto service = index.serviceForExecutable(u"konqi"_s);
+        QVERIFY(service);
+        QCOMPARE(service->icon(), u"org.kde.konqi"_s);
+        QVERIFY(!index.serviceForExecutable(u"notkonqi"_s));
+    }
+
+    void testUnitName()
+    {
+        ServiceIndex index;
+        const auto service = index.serviceForUnitName(u"app-org.kde.konqi@1a2b3c.service"_s);
+        QVERIFY(service);
+        QCOMPARE(service->icon(), u"org.kde.konqi"_s);
+        QVERIFY(!index.serviceForUnitName(u"app-org.kde.terminal@1a2b3c.service"_s));
+        QVERIFY(!index.serviceForUnitName(u"plasma-kwin_wayland.service"_s));
+    }
+
+    void testCache()
+    {
+        {
+            ServiceIndex index;
+            QVERIFY(index.serviceForExecutable(u"konqi"_s));
+        }
+        QVERIFY(QFile::exists(ServiceIndex::path()));
+
+        // A broken index must not get in the way.
+        QFile file(ServiceIndex::path());
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+        file.write("garbage");
+        file.close();
+        ServiceIndex index;
+        QVERIFY(index.serviceForExecutable(u"konqi"_s));
+    }
+};
+
+QTEST_GUILESS_MAIN(ServiceIndexTest)
+
+#include "serviceindextest.moc"
@@ -0,0 +1,212 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <ctime>
+#include <thread>
+
+#include <QTest>
+
+#include <coredump.h>
+#include <socket.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+[[nodiscard]] std::chrono::nanoseconds threadCpuTime()
+{
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+[[nodiscard]] QByteArray makePayload(qsizetype size)
+{
+    QByteArray payload(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; ++i) {
+        payload[i] = char('a' + (i % 26));
+    }
+    return payload;
+}
+} // namespace
+
+class SocketTest : public QObject
+{
+    Q_OBJECT
+
+    int m_fds[2] = {-1, -1};
+
+private Q_SLOTS:
+    void init()
+    {
+        QCOMPARE(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, m_fds), 0);
+    }
+
+    void cleanup()
+    {
+        for (auto &fd : m_fds) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    void testRoundTrip()
+    {
+        // Not a multiple of the datagram size on purpose.
+        const auto payload = makePayload(10 * Socket::DatagramSize + 123);
+        std::thread sender([this, &payload] {
+            QVERIFY(Socket::send(m_fds[0], Socket::Format::Records, payload));
+            close(m_fds[0]);
+            m_fds[0] = -1;
+        });
+        const auto received = Socket::receive(m_fds[1], 5s);
+        sender.join();
+        QVERIFY(received.has_value());
+        QCOMPARE(received->format, Socket::Format::Records);
+        QCOMPARE(received->payload, payload);
+    }
+
+    void testWithoutHeader()
+    {
+        // Older processors don't send a header. Must still work.
+        const auto payload = makePayload(Socket::DatagramSize + 1);
+        QCOMPARE(::send(m_fds[0], payload.constData(), Socket::DatagramSize, 0), ssize_t(Socket::DatagramSize));
+        QCOMPARE(::send(m_fds[0], payload.constData() + Socket::DatagramSize, 1, 0), ssize_t(1));
+        close(m_fds[0]);
+        m_fds[0] = -1;
+
+        const auto received = Socket::receive(m_fds[1], 5s);
+        QVERIFY(received.has_value());
+        QCOMPARE(received->format, Socket::Format::Json);
+        QCOMPARE(received->payload, payload);
+    }
+
+    void testTruncated()
+    {
+        const Socket::Header header{.size = 1024};
+        QCOMPARE(::send(m_fds[0], &header, sizeof(header), 0), ssize_t(sizeof(header)));
+        QCOMPARE(::send(m_fds[0], "{}", 2, 0), ssize_t(2));
+        close(m_fds[0]);
+        m_fds[0] = -1;
+
+        QVERIFY(!Socket::receive(m_fds[1], 5s).has_value());
+    }
+
+    void testNonBlocking()
+    {
+        // The long-lived launcher reads whenever the socket is readable and must never wait for the rest.
+        QCOMPARE(fcntl(m_fds[1], F_SETFL, fcntl(m_fds[1], F_GETFL) | O_NONBLOCK), 0);
+        Socket::Receiver receiver;
+        QCOMPARE(receiver.read(m_fds[1]), Socket::Receiver::State::Pending);
+
+        const auto payload = makePayload(3 * Socket::DatagramSize);
+        const Socket::Header header{.size = static_cast<quint32>(payload.size())};
+        QCOMPARE(::send(m_fds[0], &header, sizeof(header), 0), ssize_t(sizeof(header)));
+        QCOMPARE(::send(m_fds[0], payload.constData(), Socket::DatagramSize, 0), ssize_t(Socket::DatagramSize));
+        QCOMPARE(receiver.read(m_fds[1]), Socket::Receiver::State::Pending);
+
+        QCOMPARE(::send(m_fds[0], payload.constData() + Socket::DatagramSize, Socket::DatagramSize, 0), ssize_t(Socket::DatagramSize));
+        QCOMPARE(::send(m_fds[0], payload.constData() + 2 * Socket::DatagramSize, Socket::DatagramSize, 0), ssize_t(Socket::DatagramSize));
+        close(m_fds[0]);
+        m_fds[0] = -1;
+        QCOMPARE(receiver.read(m_fds[1]), Socket::Receiver::State::Finished);
+        const auto received = receiver.take();
+        QCOMPARE(received.format, Socket::Format::Records);
+        QCOMPARE(received.payload, payload);
+    }
+
+    void testOversizedHeader()
+    {
+        // The size is up to the remote. Don't even try to allocate for something silly, and don't wait for it either.
+        const Socket::Header header{.size = Socket::MaxPayloadSize + 1};
+        QCOMPARE(::send(m_fds[0], &header, sizeof(header), 0), ssize_t(sizeof(header)));
+        QVERIFY(!Socket::receive(m_fds[1], 5s).has_value());
+    }
+
+    void testOversizedWithoutHeader()
+    {
+        QCOMPARE(fcntl(m_fds[1], F_SETFL, fcntl(m_fds[1], F_GETFL) | O_NONBLOCK), 0);
+        Socket::Receiver receiver;
+        const auto datagram = makePayload(Socket::DatagramSize);
+        for (quint32 sent = 0; sent <= Socket::MaxPayloadSize; sent += Socket::DatagramSize) {
+            QCOMPARE(::send(m_fds[0], datagram.constData(), datagram.size(), 0), ssize_t(datagram.size()));
+            if (const auto state = receiver.read(m_fds[1]); state != Socket::Receiver::State::Pending) {
+                QCOMPARE(state, Socket::Receiver::State::Failed);
+                QCOMPARE(sent, Socket::MaxPayloadSize);
+                return;
+            }
+        }
+        QFAIL("receiver accepted more than the maximum payload");
+    }
+
+    void testCpuTimePerDump()
+    {
+        // The sender takes its sweet time (e.g. because journald is slow). The receiver must sleep rather than spin
+        // meanwhile, so its CPU time should be a tiny fraction of the wall time.
+        constexpr auto delay = 500ms;
+        const auto payload = makePayload(64 * 1024);
+        std::thread sender([this, &payload, delay] {
+            std::this_thread::sleep_for(delay);
+            QVERIFY(Socket::send(m_fds[0], Socket::Format::Records, payload));
+            close(m_fds[0]);
+            m_fds[0] = -1;
+        });
+
+        const auto cpuStart = threadCpuTime();
+        const auto received = Socket::receive(m_fds[1], 5s);
+        const auto cpuTime = threadCpuTime() - cpuStart;
+        sender.join();
+
+        QVERIFY(received.has_value());
+        QCOMPARE(received->payload.size(), payload.size());
+        qDebug() << "CPU time per received dump:" << std::chrono::duration_cast<std::chrono::microseconds>(cpuTime).count() << "µs";
+        QVERIFY2(cpuTime < delay / 10, "receiving spun on the CPU");
+    }
+
+    void testRecords()
+    {
+        const Coredump::EntriesHash data{
+            {"COREDUMP_EXE", "/usr/bin/konqi"},
+            {"COREDUMP_PID", "123"},
+            {"COREDUMP_PROC_MAPS", makePayload(32 * 1024)},
+            {"BINARY", QByteArray("\0\1\2", 3)},
+            {"EMPTY", QByteArray()},
+        };
+        const auto dump = Coredump::fromRecords(Coredump::toRecords(data));
+        QVERIFY(dump);
+        QCOMPARE(dump->exe, "/usr/bin/konqi");
+        QCOMPARE(dump->pid, 123);
+        for (auto it = data.cbegin(); it != data.cend(); ++it) {
+            QCOMPARE(dump->m_rawData.value(it.key()), it.value());
+        }
+
+        // Values own their data, they outlive the records as well as the dump and are NUL terminated.
+        auto records = Coredump::toRecords(data);
+        auto recordsDump = Coredump::fromRecords(records);
+        QVERIFY(recordsDump);
+        const auto exe = recordsDump->m_rawData.value("COREDUMP_EXE");
+        records.fill('x');
+        recordsDump.reset();
+        QCOMPARE(exe, "/usr/bin/konqi");
+        QCOMPARE(exe.constData()[exe.size()], '\0');
+    }
+
+    void testMalformedRecords()
+    {
+        auto records = Coredump::toRecords({{"COREDUMP_EXE", "/usr/bin/konqi"}});
+        records.chop(1);
+        QVERIFY(!Coredump::fromRecords(records));
+    }
+};
+
+QTEST_GUILESS_MAIN(SocketTest)
+
+#include "sockettest.moc"
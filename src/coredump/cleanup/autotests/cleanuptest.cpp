@@ -1,8 +1,12 @@
 /*
     SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
-    SPDX-FileCopyrightText: 2021 Harald Sitter <sitter@kde.org>
+    SPDX-FileCopyrightText: 2021-2026 Harald Sitter <sitter@kde.org>
 */
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
 #include <QProcess>
 #include <QTemporaryDir>
 #include <QTest>
@@ -11,14 +15,37 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 using namespace std::chrono_literals;
+using namespace Qt::StringLiterals;
 namespace fs = std::filesystem;
 
 class CleanupTest : public QObject
 {
     Q_OBJECT
+
+    // The cleanup also sweeps the runtime dir and the temporary files of traces, never let it near the real ones.
+    std::unique_ptr<QTemporaryDir> m_runtimeDir;
+    std::unique_ptr<QTemporaryDir> m_tmpDir;
+
+    [[nodiscard]] QProcessEnvironment environment() const
+    {
+        auto environment = QProcessEnvironment::systemEnvironment();
+        environment.insert(u"XDG_RUNTIME_DIR"_s, m_runtimeDir->path());
+        environment.insert(u"TMPDIR"_s, m_tmpDir->path());
+        return environment;
+    }
+
 private Q_SLOTS:
+    void init()
+    {
+        m_runtimeDir = std::make_unique<QTemporaryDir>();
+        QVERIFY(m_runtimeDir->isValid());
+        m_tmpDir = std::make_unique<QTemporaryDir>();
+        QVERIFY(m_tmpDir->isValid());
+    }
+
     void testRunKCrash()
     {
         // DO NOT ADD MORE STUFF HERE. We also test that we don't trip over missing directories besides kcrash-metadata!
@@ -40,11 +67,154 @@ private Q_SLOTS:
             fs::last_write_time(oldFile, time - std::chrono::weeks(2));
         }
 
-        const int exitCode = QProcess::execute(binary, {tempDir.path()});
-        QCOMPARE(exitCode, 0);
+        QProcess process;
+        process.setProcessEnvironment(environment());
+        process.start(binary, {tempDir.path()});
+        QVERIFY(process.waitForFinished());
+        QCOMPARE(process.exitCode(), 0);
         QVERIFY(fs::exists(recentFile));
         QVERIFY(!fs::exists(oldFile));
     }
+
+    void testRunCores()
+    {
+        const QString binary = QFINDTESTDATA("drkonqi-coredump-cleanup");
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+
+        const fs::path coresDir = fs::path(tempDir.path().toStdString()) / "drkonqi/cores";
+        auto makeEntry = [&coresDir](const std::string &name, std::chrono::hours age) {
+            const auto entry = coresDir / name;
+            fs::create_directories(entry);
+            {
+                std::ofstream output(entry / "core");
+                output << std::string(16384, 'x');
+            }
+            fs::last_write_time(entry, fs::last_write_time(entry) - age);
+            return entry;
+        };
+        const auto recent = makeEntry("recent", 1h);
+        const auto old = makeEntry("old", std::chrono::weeks(2));
+        const auto oldInUse = makeEntry("old-in-use", std::chrono::weeks(2));
+        const auto older = makeEntry("older", 72h);
+
+        const int usersFd = open((oldInUse / "users.lock").c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0600);
+        QVERIFY(usersFd >= 0);
+        QCOMPARE(flock(usersFd, LOCK_SH), 0);
+
+        // Only room for about two entries. "older" is the least recently used one not in use.
+        QProcess process;
+        auto environment = this->environment();
+        environment.insert(u"DRKONQI_CORE_CACHE_BUDGET"_s, QString::number(2 * 16384 + 8192));
+        process.setProcessEnvironment(environment);
+        process.start(binary, {tempDir.path()});
+        QVERIFY(process.waitForFinished());
+        QCOMPARE(process.exitCode(), 0);
+        close(usersFd);
+
+        QVERIFY(fs::exists(recent));
+        QVERIFY(fs::exists(oldInUse));
+        QVERIFY(!fs::exists(old));
+        QVERIFY(!fs::exists(older));
+    }
+
+    void testRunMemoryCores()
+    {
+        const QString binary = QFINDTESTDATA("drkonqi-coredump-cleanup");
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+
+        const fs::path coresDir = fs::path(tempDir.path().toStdString()) / "drkonqi/cores";
+        const fs::path memoryDir = fs::path(m_runtimeDir->path().toStdString()) / "drkonqi/cores";
+        fs::create_directories(memoryDir);
+        auto makeCore = [&coresDir, &memoryDir](const std::string &name, std::chrono::hours age) {
+            const auto core = memoryDir / name;
+            {
+                std::ofstream output(core);
+                output << std::string(16384, 'x');
+            }
+            const auto entry = coresDir / name;
+            fs::create_directories(entry);
+            fs::create_symlink(core, entry / "core");
+            fs::last_write_time(entry, fs::last_write_time(entry) - age);
+            return core;
+        };
+        const auto recent = makeCore("recent", 1h);
+        const auto unused = makeCore("unused", 48h);
+        const auto orphan = memoryDir / "orphan";
+        {
+            std::ofstream output(orphan);
+        }
+
+        QProcess process;
+        process.setProcessEnvironment(environment());
+        process.start(binary, {tempDir.path()});
+        QVERIFY(process.waitForFinished());
+        QCOMPARE(process.exitCode(), 0);
+
+        QVERIFY(fs::exists(recent));
+        QVERIFY(!fs::exists(unused));
+        QVERIFY(fs::is_symlink(coresDir / "unused/core")); // the entry stays and re-excavates
+        QVERIFY(!fs::exists(orphan));
+    }
+
+    void testRunCategories()
+    {
+        const QString binary = QFINDTESTDATA("drkonqi-coredump-cleanup");
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+
+        const fs::path dir = tempDir.path().toStdString();
+        auto makeFile = [](const fs::path &path, std::chrono::hours age) {
+            fs::create_directories(path.parent_path());
+            {
+                std::ofstream output(path);
+            }
+            fs::last_write_time(path, fs::last_write_time(path) - age);
+            return path;
+        };
+        const auto recentCrash = makeFile(dir / "drkonqi/crashes/recent.json", 24h);
+        const auto oldCrash = makeFile(dir / "drkonqi/crashes/old.json", std::chrono::days(100));
+        const auto recentSent = makeFile(dir / "drkonqi/sentry-sent-envelopes/recent", 24h);
+        const auto oldSent = makeFile(dir / "drkonqi/sentry-sent-envelopes/old", std::chrono::days(40));
+        const auto pending = makeFile(dir / "drkonqi/sentry-envelopes/old", std::chrono::days(40));
+        const auto oldNotResponding = makeFile(dir / "drkonqi/application-not-responding/123", std::chrono::weeks(2));
+        const fs::path traces = m_tmpDir->path().toStdString();
+        const auto oldTrace = traces / "drkonqi-AbCdEf";
+        fs::create_directories(oldTrace);
+        fs::last_write_time(oldTrace, fs::last_write_time(oldTrace) - 48h);
+        const auto recentTrace = makeFile(traces / "drkonqi.XyZaBc", 1h);
+        const auto unrelated = makeFile(traces / "kate-AbCdEf", 48h);
+
+        QProcess process;
+        process.setProcessEnvironment(environment());
+
+        // A dry run only reports.
+        process.start(binary, {u"--dry-run"_s, tempDir.path()});
+        QVERIFY(process.waitForFinished());
+        QCOMPARE(process.exitCode(), 0);
+        const auto report = process.readAllStandardOutput();
+        QVERIFY(report.contains(QByteArray::fromStdString("Would remove " + oldSent.string())));
+        QVERIFY(report.contains(QByteArray::fromStdString("Would remove " + oldTrace.string())));
+        QVERIFY(fs::exists(oldCrash));
+        QVERIFY(fs::exists(oldSent));
+        QVERIFY(fs::exists(oldTrace));
+
+        process.start(binary, {tempDir.path()});
+        QVERIFY(process.waitForFinished());
+        QCOMPARE(process.exitCode(), 0);
+        QVERIFY(process.readAllStandardOutput().isEmpty());
+
+        QVERIFY(fs::exists(recentCrash));
+        QVERIFY(!fs::exists(oldCrash));
+        QVERIFY(fs::exists(recentSent));
+        QVERIFY(!fs::exists(oldSent));
+        QVERIFY(fs::exists(pending)); // not sent yet, not ours to clean
+        QVERIFY(!fs::exists(oldNotResponding));
+        QVERIFY(!fs::exists(oldTrace));
+        QVERIFY(fs::exists(recentTrace));
+        QVERIFY(fs::exists(unrelated));
+    }
 };
 
 QTEST_GUILESS_MAIN(CleanupTest)
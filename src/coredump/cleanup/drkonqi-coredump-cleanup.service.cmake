@@ -5,6 +5,11 @@
 Description=Cleaning DrKonqi data
 ConditionPathExistsGlob=|%C/kcrash-metadata/*.ini
 ConditionPathExistsGlob=|%C/drkonqi/cores/*
+ConditionPathExistsGlob=|%C/drkonqi/crashes/*
+ConditionPathExistsGlob=|%C/drkonqi/sentry-sent-envelopes/*
+ConditionPathExistsGlob=|%C/drkonqi/application-not-responding/*
+ConditionPathExistsGlob=|%t/drkonqi/cores/*
+ConditionPathExistsGlob=|%T/drkonqi[-.]*
 PartOf=graphical-session.target
 After=plasma-core.target
 
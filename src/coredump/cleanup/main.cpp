@@ -1,40 +1,325 @@
 // SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 // SPDX-FileCopyrightText: 2021-2026 Harald Sitter <sitter@kde.org>
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace std::chrono_literals;
 
 namespace
 {
-// Heart of the cleanup logic. May throw.
-bool cleanup(const std::filesystem::directory_entry &path)
+// Keep in sync with AutomaticCoredumpExcavator.
+constexpr auto USERS_LOCK = "users.lock";
+constexpr auto EXTRACTION_LOCK = "extraction.lock";
+// Cores are big, even with holes. Beyond this the least recently used entries get evicted regardless of age.
+// Can be overridden through DRKONQI_CORE_CACHE_BUDGET (in bytes).
+constexpr std::uintmax_t DEFAULT_CORE_CACHE_BUDGET = 4ULL * 1024 * 1024 * 1024;
+constexpr std::uintmax_t MiB = 1024ULL * 1024;
+constexpr auto UNLIMITED = std::numeric_limits<std::uintmax_t>::max();
+
+class FileLock
 {
-    const auto lastModified = path.last_write_time();
-    const auto now = decltype(lastModified)::clock().now();
-    const auto age = now - lastModified;
-    // Plenty of time so we won't take away the file from underneath drkonqi.
-    if (age >= std::chrono::weeks(1)) {
-        std::filesystem::remove_all(path);
+public:
+    // Takes an exclusive lock without blocking. Fails if anyone holds the lock in any way.
+    explicit FileLock(const std::filesystem::path &path)
+        : m_fd(open(path.c_str(), O_RDONLY | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600))
+    {
+        if (m_fd >= 0 && flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+    ~FileLock()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+    FileLock(FileLock &&) = delete;
+    FileLock &operator=(FileLock &&) = delete;
+
+    [[nodiscard]] bool isLocked() const
+    {
+        return m_fd >= 0;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+std::chrono::system_clock::time_point toTimePoint(const timespec &time)
+{
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec)));
+}
+
+// Space actually used on disk, cores are sparse.
+std::uintmax_t physicalSize(const std::filesystem::path &path)
+{
+    struct stat info{};
+    if (lstat(path.c_str(), &info) != 0) {
+        return 0;
+    }
+    std::uintmax_t size = std::uintmax_t(info.st_blocks) * 512;
+    if (!S_ISDIR(info.st_mode)) {
+        return size;
+    }
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (lstat(entry.path().c_str(), &info) == 0) {
+            size += std::uintmax_t(info.st_blocks) * 512;
+        }
+    }
+    return size;
+}
+
+std::string formatSize(std::uintmax_t size)
+{
+    constexpr std::string_view units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    auto value = double(size);
+    std::size_t unit = 0;
+    for (; value >= 1024 && unit + 1 < std::size(units); ++unit) {
+        value /= 1024;
+    }
+    auto text = std::to_string(std::uintmax_t(value * 10) / 10);
+    if (unit > 0) {
+        text += "." + std::to_string(std::uintmax_t(value * 10) % 10);
+    }
+    return text + " " + std::string(units[unit]);
+}
+
+std::uintmax_t coreCacheBudget()
+{
+    if (const char *budget = std::getenv("DRKONQI_CORE_CACHE_BUDGET"); budget != nullptr) {
+        try {
+            return std::stoull(budget);
+        } catch (const std::exception &) {
+            std::cerr << "Invalid DRKONQI_CORE_CACHE_BUDGET " << budget << "\n";
+        }
+    }
+    return DEFAULT_CORE_CACHE_BUDGET;
+}
+
+// A kind of data we leave behind. Entries (the direct children of path passing select) expire by age, on top of that
+// the least recently used ones get evicted while the category is over its size budget.
+struct Category {
+    std::string name;
+    std::filesystem::path path;
+    std::chrono::seconds maxAge;
+    std::uintmax_t budget = UNLIMITED;
+    std::function<bool(const std::filesystem::directory_entry &)> select = [](const auto &) {
+        return true;
+    };
+    // Entries are core cache entries, which are in use while anyone holds their locks.
+    bool locked = false;
+};
+
+struct Entry {
+    std::filesystem::path path;
+    // Expiry goes by modification. That is when we created the data.
+    std::chrono::system_clock::time_point modified;
+    // Eviction goes by use. Reading counts as use, except for directories, reading those is merely us scanning them.
+    // Core cache users touch their entry instead.
+    std::chrono::system_clock::time_point lastUsed;
+    std::uintmax_t size = 0;
+};
+
+struct Report {
+    std::size_t entries = 0;
+    std::uintmax_t size = 0;
+    std::size_t freedEntries = 0;
+    std::uintmax_t freedSize = 0;
+};
+
+std::optional<std::vector<Entry>> scan(const Category &category)
+try {
+    std::vector<Entry> entries;
+    if (!std::filesystem::exists(category.path)) {
+        return entries;
+    }
+    for (const auto &entry : std::filesystem::directory_iterator(category.path)) {
+        struct stat info{};
+        if (!category.select(entry) || lstat(entry.path().c_str(), &info) != 0) {
+            continue;
+        }
+        const auto modified = toTimePoint(info.st_mtim);
+        const auto lastUsed = S_ISDIR(info.st_mode) ? modified : std::max(modified, toTimePoint(info.st_atim));
+        entries.push_back({.path = entry.path(), .modified = modified, .lastUsed = lastUsed, .size = physicalSize(entry.path())});
+    }
+    return entries;
+} catch (const std::filesystem::filesystem_error &error) {
+    std::cerr << "Failed to scan: " << category.path << " " << error.what() << "\n";
+    return std::nullopt;
+}
+
+bool evict(const Category &category, std::vector<Entry> entries, bool dryRun, Report &report)
+try {
+    // Oldest first
+    std::ranges::sort(entries, {}, &Entry::lastUsed);
+    report.entries = entries.size();
+    for (const auto &entry : entries) {
+        report.size += entry.size;
+    }
+
+    auto totalSize = report.size;
+    const auto now = std::chrono::system_clock::now();
+    for (const auto &entry : entries) {
+        const bool expired = now - entry.modified >= category.maxAge;
+        if (!expired && totalSize <= category.budget) {
+            continue;
+        }
+        if (category.locked) {
+            // Hold the locks while removing so nobody starts using the entry in the meantime.
+            const FileLock usersLock(entry.path / USERS_LOCK);
+            const FileLock extractionLock(entry.path / EXTRACTION_LOCK);
+            if (!usersLock.isLocked() || !extractionLock.isLocked()) {
+                continue; // in use
+            }
+            if (!dryRun) {
+                std::filesystem::remove_all(entry.path);
+            }
+        } else if (!dryRun) {
+            std::filesystem::remove_all(entry.path);
+        }
+        if (dryRun) {
+            std::cout << "Would remove " << entry.path.string() << " (" << formatSize(entry.size) << ", "
+                      << (expired ? "expired" : "over budget") << ")\n";
+        }
+        totalSize -= entry.size;
+        ++report.freedEntries;
+        report.freedSize += entry.size;
     }
     return true;
+} catch (const std::filesystem::filesystem_error &error) {
+    std::cerr << "Failed to clean: " << category.path << " " << error.what() << "\n";
+    return false;
 }
 
-template<typename Precondition>
-bool clean(const auto &path, const Precondition &precondition)
+std::vector<Category> categories(const std::filesystem::path &cachePath)
+{
+    std::vector<Category> categories;
+    // Plenty of time so we won't take away the file from underneath drkonqi.
+    categories.push_back({
+        .name = "KCrash metadata",
+        .path = cachePath / "kcrash-metadata",
+        .maxAge = std::chrono::weeks(1),
+        .budget = 64 * MiB,
+        .select =
+            [](const auto &entry) {
+                return entry.path().extension() == ".ini";
+            },
+    });
+    // The GUI needs these to tell KDE crashes apart and to remember what got reported. Keep them about as long as
+    // systemd-coredump typically keeps the crash itself.
+    categories.push_back({
+        .name = "Crash metadata",
+        .path = cachePath / "drkonqi/crashes",
+        .maxAge = std::chrono::days(90),
+        .budget = 64 * MiB,
+    });
+    // Only kept for reference, the pending envelopes in sentry-envelopes are none of our business.
+    categories.push_back({
+        .name = "Sent Sentry envelopes",
+        .path = cachePath / "drkonqi/sentry-sent-envelopes",
+        .maxAge = std::chrono::days(30),
+        .budget = 64 * MiB,
+    });
+    categories.push_back({
+        .name = "Application not responding markers",
+        .path = cachePath / "drkonqi/application-not-responding",
+        .maxAge = std::chrono::weeks(1),
+        .budget = 16 * MiB,
+    });
+    categories.push_back({
+        .name = "Cores",
+        .path = cachePath / "drkonqi/cores",
+        .maxAge = std::chrono::weeks(1),
+        .budget = coreCacheBudget(),
+        .select =
+            [](const auto &entry) {
+                return entry.is_directory();
+            },
+        .locked = true,
+    });
+    // Temporary files of trace generation (QTemporaryDir/QTemporaryFile named after the application). They only
+    // linger when drkonqi didn't get to clean up after itself. Nobody needs them once the trace is done.
+    std::error_code error;
+    if (const auto tempPath = std::filesystem::temp_directory_path(error); !error) {
+        categories.push_back({
+            .name = "Trace temporary files",
+            .path = tempPath,
+            .maxAge = std::chrono::days(1),
+            .select =
+                [](const auto &entry) {
+                    const auto name = entry.path().filename().string();
+                    if (!name.starts_with("drkonqi-") && !name.starts_with("drkonqi.")) {
+                        return false;
+                    }
+                    struct stat info{};
+                    return lstat(entry.path().c_str(), &info) == 0 && info.st_uid == getuid()
+                        && (S_ISDIR(info.st_mode) || S_ISREG(info.st_mode));
+                },
+        });
+    }
+    return categories;
+}
+
+// Cores placed in memory (see CorePlacement) are linked from their cache entry and named after it. They go away with
+// their entry, or sooner when unused for a day, memory is more precious than disk. The entry stays and re-excavates
+// when needed again.
+bool cleanMemoryCores(const std::filesystem::path &path, const std::filesystem::path &entriesPath, bool dryRun)
 try {
     if (!std::filesystem::exists(path)) {
         return true;
     }
-    return std::ranges::all_of(std::filesystem::directory_iterator(path), [&](const auto &path) {
-        if (!precondition(path)) {
-            return true;
+
+    auto remove = [dryRun](const std::filesystem::path &core, std::string_view reason) {
+        if (dryRun) {
+            std::cout << "Would remove " << core.string() << " (" << formatSize(physicalSize(core)) << ", " << reason << ")\n";
+            return;
         }
-        return cleanup(path);
-    });
+        std::filesystem::remove(core);
+    };
+
+    const auto now = std::filesystem::file_time_type::clock::now();
+    for (const auto &core : std::filesystem::directory_iterator(path)) {
+        const auto name = core.path().filename().string();
+        const auto entryPath = entriesPath / name.substr(0, name.find('.')); // partial cores have a random suffix
+        if (!std::filesystem::is_directory(entryPath)) {
+            remove(core.path(), "orphaned");
+            continue;
+        }
+        const bool unused = now - std::filesystem::last_write_time(entryPath) >= std::chrono::days(1);
+        const bool partial = name.find('.') != std::string::npos;
+        if (!unused && !partial) {
+            continue;
+        }
+        const FileLock usersLock(entryPath / USERS_LOCK);
+        const FileLock extractionLock(entryPath / EXTRACTION_LOCK);
+        if (!extractionLock.isLocked() || (!partial && !usersLock.isLocked())) {
+            continue; // in use (partials are only in use while someone is extracting)
+        }
+        remove(core.path(), partial ? "partial" : "unused");
+    }
+    return true;
 } catch (const std::filesystem::filesystem_error &error) {
     std::cerr << "Failed to clean: " << path << " " << error.what() << "\n";
     return false;
@@ -44,28 +329,54 @@ try {
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        std::cerr << "Need cache path as argument\n";
+    bool dryRun = false;
+    std::vector<std::string_view> arguments;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--dry-run") {
+            dryRun = true;
+        } else {
+            arguments.emplace_back(argv[i]);
+        }
+    }
+    if (arguments.size() != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--dry-run] <cache path>\n";
         return 1;
     }
 
-    const std::filesystem::path cachePath = argv[1];
+    const std::filesystem::path cachePath = arguments.front();
     if (!std::filesystem::exists(cachePath)) {
         std::cerr << "Cache path doesn't exist " << cachePath << "\n";
         return 1;
     }
 
+    // Scanning is the expensive part (the core cache in particular is walked in full to get at the physical sizes),
+    // and the categories are independent of one another. Removal happens one category after another.
+    const auto allCategories = categories(cachePath);
+    std::vector<std::future<std::optional<std::vector<Entry>>>> scans;
+    scans.reserve(allCategories.size());
+    for (const auto &category : allCategories) {
+        scans.push_back(std::async(std::launch::async, scan, std::cref(category)));
+    }
+
     auto ret = 0;
-    if (!clean(cachePath / "kcrash-metadata", [](const auto &path) {
-            return path.path().extension() == ".ini";
-        })) {
-        std::cerr << "Failed to clean KCrash metadata\n";
-        ret = 1;
+    for (std::size_t i = 0; i < allCategories.size(); ++i) {
+        const auto &category = allCategories.at(i);
+        auto entries = scans.at(i).get();
+        Report report;
+        if (!entries || !evict(category, std::move(*entries), dryRun, report)) {
+            std::cerr << "Failed to clean " << category.name << "\n";
+            ret = 1;
+            continue;
+        }
+        if (dryRun) {
+            std::cout << category.name << ": " << report.entries << " entries, " << formatSize(report.size) << ", would free "
+                      << report.freedEntries << " entries, " << formatSize(report.freedSize) << "\n";
+        }
     }
-    if (!clean(cachePath / "drkonqi/cores", [](const auto &path) {
-            return path.is_directory();
-        })) {
-        std::cerr << "Failed to clean cores\n";
+    // After the entries, so cores of evicted entries go right away.
+    if (const char *runtimePath = std::getenv("XDG_RUNTIME_DIR"); runtimePath != nullptr
+        && !cleanMemoryCores(std::filesystem::path(runtimePath) / "drkonqi/cores", cachePath / "drkonqi/cores", dryRun)) {
+        std::cerr << "Failed to clean cores in memory\n";
         ret = 1;
     }
     return ret;
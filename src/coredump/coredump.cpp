@@ -5,6 +5,9 @@
 
 #include "coredump.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <QVariant>
 
 using namespace Qt::StringLiterals;
@@ -19,6 +22,7 @@ Coredump::Coredump(QByteArray cursor, EntriesHash data)
     , systemd_unit(QString::fromLocal8Bit(m_rawData[QByteArrayLiteral("_SYSTEMD_UNIT")]))
     , bootId(QString::fromUtf8(m_rawData["_BOOT_ID"_ba]))
     , timestamp(QString::fromUtf8(m_rawData["COREDUMP_TIMESTAMP"_ba]))
+    , crashCount(std::max(m_rawData.value(keyCrashCount(), "1"_ba).toInt(), 1))
 {
     if (!m_rawData.contains(keyCursor())) {
         m_rawData[keyCursor()] = m_cursor; // so we can easily access it in launcher & drkonqi
@@ -30,6 +34,67 @@ Coredump::Coredump(const QJsonDocument &document)
 {
 }
 
+std::unique_ptr<Coredump> Coredump::fromRecords(const QByteArray &records)
+{
+    auto data = recordsToHash(records);
+    if (!data.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<Coredump>(QByteArray() /* not from journal, has no cursor */, std::move(data.value()));
+}
+
+QByteArray Coredump::toRecords(const EntriesHash &data)
+{
+    qsizetype size = 0;
+    for (auto it = data.cbegin(); it != data.cend(); ++it) {
+        size += 2 * sizeof(quint32) + it.key().size() + it.value().size();
+    }
+
+    QByteArray records;
+    records.reserve(size);
+    auto append = [&records](const QByteArray &field) {
+        const auto fieldSize = static_cast<quint32>(field.size());
+        records.append(reinterpret_cast<const char *>(&fieldSize), sizeof(fieldSize));
+        records.append(field);
+    };
+    for (auto it = data.cbegin(); it != data.cend(); ++it) {
+        append(it.key());
+        append(it.value());
+    }
+    return records;
+}
+
+std::optional<Coredump::EntriesHash> Coredump::recordsToHash(const QByteArray &records)
+{
+    qsizetype offset = 0;
+    auto take = [&records, &offset]() -> std::optional<QByteArray> {
+        quint32 size = 0;
+        if (records.size() - offset < qsizetype(sizeof(size))) {
+            return std::nullopt;
+        }
+        std::memcpy(&size, records.constData() + offset, sizeof(size));
+        offset += sizeof(size);
+        if (records.size() - offset < qsizetype(size)) {
+            return std::nullopt;
+        }
+        // A deep copy. The values get passed around (and outlive the records) so they must own their data.
+        auto field = QByteArray(records.constData() + offset, size);
+        offset += size;
+        return field;
+    };
+
+    EntriesHash hash;
+    while (offset < records.size()) {
+        auto key = take();
+        auto value = take();
+        if (!key.has_value() || !value.has_value()) {
+            return std::nullopt;
+        }
+        hash.insert(key.value(), value.value());
+    }
+    return hash;
+}
+
 QByteArray Coredump::keyFilename()
 {
     return QByteArrayLiteral("COREDUMP_FILENAME");
@@ -54,3 +119,8 @@ QByteArray Coredump::keyCursor()
 {
     return "_DRKONQI_SD_CURSOR"_ba;
 }
+
+QByteArray Coredump::keyCrashCount()
+{
+    return "_DRKONQI_CRASH_COUNT"_ba;
+}
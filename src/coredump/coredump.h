@@ -10,6 +10,9 @@
 #include <QJsonDocument>
 #include <QString>
 
+#include <memory>
+#include <optional>
+
 #include "memory.h"
 
 class Coredump
@@ -19,6 +22,10 @@ public:
 
     Coredump(QByteArray cursor, EntriesHash data);
     explicit Coredump(const QJsonDocument &document);
+    // From the compact record serialization (see toRecords). Returns nullptr when the records are malformed.
+    [[nodiscard]] static std::unique_ptr<Coredump> fromRecords(const QByteArray &records);
+    // Length-prefixed key/value records: (quint32 size, key, quint32 size, value)...
+    [[nodiscard]] static QByteArray toRecords(const EntriesHash &data);
 
     ~Coredump() = default;
 
@@ -26,6 +33,7 @@ public:
     static QByteArray keyFilename();
     static QByteArray keyPickup();
     static QByteArray keyCursor();
+    static QByteArray keyCrashCount();
 
     // Other bits and bobs
     QByteArray m_cursor;
@@ -39,8 +47,10 @@ public:
     QString systemd_unit;
     QString bootId;
     QString timestamp;
+    int crashCount = 1; // how many crashes this dump stands for, see Admission
 
 private:
     static EntriesHash documentToHash(const QJsonDocument &document);
+    static std::optional<EntriesHash> recordsToHash(const QByteArray &records);
     Q_DISABLE_COPY_MOVE(Coredump)
 };
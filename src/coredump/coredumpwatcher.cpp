@@ -5,6 +5,7 @@
 
 #include "coredumpwatcher.h"
 
+#include <QByteArrayView>
 #include <QDebug>
 
 #include <cerrno>
@@ -20,7 +21,23 @@
 
 using namespace Qt::StringLiterals;
 
-static std::optional<Coredump> makeDump(sd_journal *context)
+namespace
+{
+constexpr QByteArrayView CORE_FIELD = "COREDUMP";
+
+// Splits KEY=VALUE field data. Only the parts we keep get copied.
+[[nodiscard]] std::optional<std::pair<QByteArrayView, QByteArrayView>> splitField(const void *data, size_t length)
+{
+    const QByteArrayView field(static_cast<const char *>(data), static_cast<qsizetype>(length));
+    const auto offset = field.indexOf('=');
+    if (offset < 0) {
+        return std::nullopt;
+    }
+    return std::make_pair(field.first(offset), field.sliced(offset + 1));
+}
+} // namespace
+
+static std::optional<Coredump> makeDump(sd_journal *context, const QList<QByteArray> &fields)
 {
     auto cursorExpected = contextual_owning_ptr_call<char>(sd_journal_get_cursor, context, std::free);
     if (cursorExpected.ret != 0) {
@@ -31,32 +48,44 @@ static std::optional<Coredump> makeDump(sd_journal *context)
     Coredump::EntriesHash entries;
     const void *data = nullptr;
     size_t length = 0;
+
+    if (!fields.isEmpty()) {
+        entries.reserve(fields.size());
+        for (const auto &key : fields) {
+            if (sd_journal_get_data(context, key.constData(), &data, &length) != 0) {
+                continue; // not in this entry
+            }
+            if (const auto field = splitField(data, length)) {
+                entries.insert(key, field->second.toByteArray());
+            }
+        }
+        if (fields.contains(Coredump::keyFilename()) && !entries.contains(Coredump::keyFilename())
+            && sd_journal_get_data(context, CORE_FIELD.data(), &data, &length) == 0) {
+            // Core stored in the journal, see below.
+            entries.insert(Coredump::keyFilename(), QByteArrayLiteral("/dev/null"));
+        }
+        return std::make_optional<Coredump>(cursorExpected.value.get(), entries);
+    }
+
     SD_JOURNAL_FOREACH_DATA(context, data, length)
     {
-        // size_t is uint, QBA uses int, make sure we don't overflow the int!
-        int dataSize = static_cast<int>(length);
-        Q_ASSERT(dataSize >= 0);
-        Q_ASSERT(static_cast<quint64>(dataSize) == length);
-
-        QByteArray entry(static_cast<const char *>(data), dataSize);
-        const auto offset = entry.indexOf('=');
-        if (offset < 0) {
-            qWarning() << "this entry looks funny it has no separating = character" << entry;
+        const auto field = splitField(data, length);
+        if (!field.has_value()) {
+            qWarning() << "this entry looks funny it has no separating = character" << QByteArrayView(static_cast<const char *>(data), qsizetype(length));
             continue;
         }
 
-        const QByteArray key = entry.left(offset);
-        if (key == QByteArrayLiteral("COREDUMP")) {
+        const auto &[key, value] = field.value();
+        if (key == CORE_FIELD) {
             // The literal COREDUMP= entry is the actual core when configured for journal storage in coredump.conf.
             // Synthesize a filename instead so we can use the same validity checks for all storage types.
+            // Never copy the value, it may be huge. JournalEntry::streamCore extracts it when the core is needed.
             entries.insert(Coredump::keyFilename(), QByteArrayLiteral("/dev/null"));
             continue;
         }
 
-        const QByteArray value = entry.mid(offset + 1);
-
         // Always add to raw data, they get serialized back into the INI file for drkonqi.
-        entries.insert(key, value);
+        entries.insert(key.toByteArray(), value.toByteArray());
     }
 
     return std::make_optional<Coredump>(cursorExpected.value.get(), entries);
@@ -75,8 +104,11 @@ void CoredumpWatcher::processLog()
 {
     int i = 0;
     while (sd_journal_next(context.get()) > 0) {
+        if (std::exchange(skipCursorEntry, false) && sd_journal_test_cursor(context.get(), cursor.constData()) > 0) {
+            continue; // already seen that one
+        }
         ++i;
-        const auto optionalDump = makeDump(context.get());
+        const auto optionalDump = makeDump(context.get(), fields);
         if (!optionalDump.has_value()) {
             qWarning() << "Failed to make a dump :O";
             continue;
@@ -150,6 +182,13 @@ void CoredumpWatcher::start()
         }
     }
 
+    if (dataThreshold.has_value()) {
+        if (int ret = sd_journal_set_data_threshold(context.get(), dataThreshold.value()); ret != 0) {
+            errnoError(QStringLiteral("Failed to set data threshold"), -ret);
+            return;
+        }
+    }
+
     for (const auto &match : matches) {
         if (sd_journal_add_match(context.get(), qUtf8Printable(match), 0) != 0) {
             Q_EMIT error(u"Failed to install custom match: %1"_s.arg(match));
@@ -171,7 +210,19 @@ void CoredumpWatcher::start()
         processLog();
     });
 
-    if (int ret = sd_journal_seek_head(context.get()); ret != 0) {
+    if (!cursor.isEmpty()) {
+        if (int ret = sd_journal_seek_cursor(context.get(), cursor.constData()); ret != 0) {
+            errnoError(QStringLiteral("Failed to seek to cursor"), -ret);
+            return;
+        }
+        skipCursorEntry = true;
+    } else if (since.has_value()) {
+        const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(since->time_since_epoch()).count();
+        if (int ret = sd_journal_seek_realtime_usec(context.get(), static_cast<uint64_t>(usec)); ret != 0) {
+            errnoError(QStringLiteral("Failed to seek to realtime"), -ret);
+            return;
+        }
+    } else if (int ret = sd_journal_seek_head(context.get()); ret != 0) {
         errnoError(QStringLiteral("Failed to go to tail"), -fd);
         return;
     }
@@ -184,4 +235,24 @@ void CoredumpWatcher::addMatch(const QString &str)
     matches.push_back(str);
 }
 
+void CoredumpWatcher::setFields(QList<QByteArray> fields_)
+{
+    fields = std::move(fields_);
+}
+
+void CoredumpWatcher::setDataThreshold(size_t threshold)
+{
+    dataThreshold = threshold;
+}
+
+void CoredumpWatcher::setSince(std::chrono::system_clock::time_point since_)
+{
+    since = since_;
+}
+
+void CoredumpWatcher::setCursor(QByteArray cursor_)
+{
+    cursor = std::move(cursor_);
+}
+
 #include "moc_coredumpwatcher.cpp"
@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <optional>
+
 #include <QObject>
 #include <QSocketNotifier>
 
@@ -21,6 +24,16 @@ public:
 
     // must be called before start!
     void addMatch(const QString &str);
+    // Only read these fields of every entry instead of all of them. Must be called before start!
+    // Fields that aren't projected can still be fetched lazily through JournalEntry.
+    void setFields(QList<QByteArray> fields);
+    // Maximum size of field data to read (see sd_journal_set_data_threshold). 0 means unlimited. Must be called before start!
+    void setDataThreshold(size_t threshold);
+    // Start reading at this point in time instead of the head of the journal. Must be called before start!
+    void setSince(std::chrono::system_clock::time_point since);
+    // Continue after the entry at this cursor instead of the head of the journal. Takes precedence over setSince.
+    // Must be called before start!
+    void setCursor(QByteArray cursor);
     void start();
 
 Q_SIGNALS:
@@ -40,4 +53,9 @@ private:
     const QString instance;
     const QString instanceFilter; // systemd-coredump@%1 instance name
     QStringList matches;
+    QList<QByteArray> fields;
+    std::optional<size_t> dataThreshold;
+    std::optional<std::chrono::system_clock::time_point> since;
+    QByteArray cursor;
+    bool skipCursorEntry = false;
 };
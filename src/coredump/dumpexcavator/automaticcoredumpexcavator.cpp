@@ -4,98 +4,438 @@
 #include "automaticcoredumpexcavator.h"
 
 #include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
 
+#include <QCryptographicHash>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusMessage>
 #include <QDBusPendingCallWatcher>
 #include <QDBusUnixFileDescriptor>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QLocale>
+#include <QScopeGuard>
 #include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QtConcurrentRun>
 
 #include <KLocalizedString>
 
 #include "coredumpexcavator.h"
+#include "coremodules.h"
+#include "coreplacement.h"
+#include "journalentry.h"
+#include "nativeexcavator.h"
 
 using namespace Qt::StringLiterals;
 using namespace std::chrono_literals;
 
-void AutomaticCoredumpExcavator::excavateFrom(const QString &coredumpFilename)
+namespace
 {
-    if (!m_coreDir || !m_coreDir->isValid()) { // lazy init m_coreDir
-        const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + u"/cores/"_s;
-        QDir().mkpath(cacheDir);
+// Keep in sync with drkonqi-coredump-cleanup.
+constexpr auto USERS_LOCK = "users.lock"_L1;
+constexpr auto EXTRACTION_LOCK = "extraction.lock"_L1;
+constexpr auto CORE = "core"_L1;
+// What CoredumpWatcher puts as COREDUMP_FILENAME when the core is stored in the journal.
+constexpr auto JOURNAL_CORE_FILENAME = "/dev/null"_L1;
 
-        m_coreDir = std::make_unique<QTemporaryDir>(u"%1/%2-XXXXXX"_s.arg(cacheDir, QDateTime::currentDateTime().toString(Qt::ISODateWithMs)));
-        Q_ASSERT(m_coreDir->isValid());
-        if (!m_coreDir->isValid()) {
-            Q_EMIT failed(
-                i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to create core directory: %1", m_coreDir->errorString()));
+[[nodiscard]] int openLock(const QString &path)
+{
+    return open(QFile::encodeName(path).constData(), O_RDONLY | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+}
+
+[[nodiscard]] int flockRetrying(int fd, int operation)
+{
+    int ret = 0;
+    do {
+        ret = flock(fd, operation);
+    } while (ret != 0 && errno == EINTR);
+    return ret;
+}
+
+void closeFd(int &fd)
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+} // namespace
+
+AutomaticCoredumpExcavator::~AutomaticCoredumpExcavator()
+{
+    closeFd(m_extractionFd);
+    releaseEntry();
+}
+
+QString AutomaticCoredumpExcavator::cacheLocation()
+{
+    // Deliberately not CacheLocation, that one differs between drkonqi and drkonqi-coredump-gui.
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + u"/drkonqi/cores/"_s;
+}
+
+QString AutomaticCoredumpExcavator::corePath() const
+{
+    return m_entryPath + '/'_L1 + CORE;
+}
+
+QString AutomaticCoredumpExcavator::memoryCorePath() const
+{
+    return CorePlacement::memoryLocation() + QFileInfo(m_entryPath).fileName();
+}
+
+void AutomaticCoredumpExcavator::setFreeRAM(std::optional<quint64> freeRAM)
+{
+    m_freeRAM = freeRAM;
+}
+
+bool AutomaticCoredumpExcavator::isInMemory() const
+{
+    return !m_entryPath.isEmpty() && CorePlacement::isInMemory(corePath());
+}
+
+void AutomaticCoredumpExcavator::moveToDisk()
+{
+    if (m_movingToDisk || !isInMemory()) {
+        return;
+    }
+    // Nobody may be excavating while we shuffle the core around. If someone is, they'll be done soon enough and
+    // the next pressure notification will get us another go.
+    const int lockFd = openLock(m_entryPath + '/'_L1 + EXTRACTION_LOCK);
+    if (lockFd < 0 || flockRetrying(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        if (lockFd >= 0) {
+            close(lockFd);
+        }
+        return;
+    }
+
+    qDebug() << "Moving core to disk" << corePath();
+    m_movingToDisk = true;
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        m_movingToDisk = false;
+        if (!watcher->result()) {
+            qWarning() << "Failed to move core to disk, it stays in memory";
             return;
         }
-        // Keep the core to ourself.
-        std::filesystem::permissions(m_coreDir->path().toStdString(), std::filesystem::perms::owner_all, std::filesystem::perm_options::replace);
+        Q_EMIT movedToDisk();
+    });
+    // Everything happens in the thread, including unlocking. Should we get destroyed meanwhile the move still
+    // completes properly.
+    watcher->setFuture(QtConcurrent::run([corePath = corePath(), memoryCorePath = memoryCorePath(), lockFd] {
+        const auto unlock = qScopeGuard([lockFd] {
+            close(lockFd);
+        });
+        QTemporaryFile diskCore(corePath + u".XXXXXX"_s);
+        if (!diskCore.open() || NativeExcavator::excavate(memoryCorePath, diskCore.handle()) != NativeExcavator::Result::Excavated) {
+            return false;
+        }
+        // Replaces the symlink.
+        if (::rename(QFile::encodeName(diskCore.fileName()).constData(), QFile::encodeName(corePath).constData()) != 0) {
+            return false;
+        }
+        diskCore.setAutoRemove(false);
+        QFile::remove(memoryCorePath);
+        return true;
+    }));
+}
+
+bool AutomaticCoredumpExcavator::acquireEntry(const QByteArray &entryName)
+{
+    // The name is unique per crash (the file name contains the boot id, pid and timestamp). Hashing the content would
+    // mean reading the entire core, which is what we are trying not to do more than once.
+    const auto key = QString::fromLatin1(QCryptographicHash::hash(entryName, QCryptographicHash::Sha256).toHex());
+    const auto entryPath = cacheLocation() + key;
+    if (m_usersFd >= 0 && entryPath == m_entryPath) {
+        return true; // retrying, we still hold the entry
     }
+    releaseEntry();
 
-    const auto coreFileTarget = m_coreDir->filePath(u"core"_s);
-    const auto coredumpFileInfo = QFileInfo(coredumpFilename);
+    // The cleanup may be removing the very entry we are trying to get. It holds the users lock exclusively while doing
+    // so. Once we get our shared lock check that the lock file wasn't unlinked underneath us, and start over if it was.
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        if (!QDir().mkpath(entryPath)) {
+            break;
+        }
+        // Keep the cores to ourself.
+        std::filesystem::permissions(cacheLocation().toStdString(), std::filesystem::perms::owner_all, std::filesystem::perm_options::replace);
+        std::filesystem::permissions(entryPath.toStdString(), std::filesystem::perms::owner_all, std::filesystem::perm_options::replace);
+
+        const int fd = openLock(entryPath + '/'_L1 + USERS_LOCK);
+        if (fd < 0 || flockRetrying(fd, LOCK_SH) != 0) {
+            qWarning() << "Failed to lock core cache entry" << entryPath << strerror(errno);
+            if (fd >= 0) {
+                close(fd);
+            }
+            break;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_nlink == 0) {
+            close(fd);
+            continue;
+        }
+        m_usersFd = fd;
+        m_entryPath = entryPath;
+        // The cleanup evicts by age, mark the entry as used.
+        utimensat(AT_FDCWD, QFile::encodeName(entryPath).constData(), nullptr, 0);
+        return true;
+    }
+
+    Q_EMIT failed(i18nc("diagnostic error. %1 is a directory path", "Failed to create core directory: %1", entryPath));
+    return false;
+}
+
+void AutomaticCoredumpExcavator::releaseEntry()
+{
+    if (m_usersFd < 0) {
+        return;
+    }
+    // A move to disk in progress takes care of the memory copy itself.
+    const bool inMemory = isInMemory() && !m_movingToDisk;
+    closeFd(m_usersFd);
 
-    auto coreFile = std::make_shared<QFile>(coreFileTarget);
-    if (coreFile->exists()) {
-        qDebug() << "Core already exists, returning early";
-        Q_EMIT excavated(coreFileTarget);
+    // A core in memory is memory nobody else gets to use (and MemoryFence keeps accounting for it). Once the last user
+    // is gone, throw it away. The entry stays and the core gets excavated again should it be needed after all.
+    // Users take their shared lock before looking at the core, if we get the exclusive lock nobody is using it.
+    if (inMemory) {
+        const int fd = openLock(m_entryPath + '/'_L1 + USERS_LOCK);
+        if (fd >= 0 && flockRetrying(fd, LOCK_EX | LOCK_NB) == 0) {
+            qDebug() << "Last user of the core in memory, removing it" << memoryCorePath();
+            QFile::remove(memoryCorePath());
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    m_entryPath.clear();
+}
+
+void AutomaticCoredumpExcavator::unlockExtraction()
+{
+    closeFd(m_extractionFd);
+}
+
+void AutomaticCoredumpExcavator::excavateFrom(const QString &coredumpFilename, const QByteArray &journalCursor)
+{
+    if (m_extractionFd >= 0) {
+        qDebug() << "Already excavating";
+        return;
+    }
+    const bool inJournal = coredumpFilename == JOURNAL_CORE_FILENAME;
+    if (inJournal && journalCursor.isEmpty()) {
+        Q_EMIT failed(i18nc("diagnostic error", "The core is stored in the journal but its journal entry is unknown"));
+        return;
+    }
+    m_journalCursor = inJournal ? journalCursor : QByteArray();
+    if (!acquireEntry(inJournal ? journalCursor : QFileInfo(coredumpFilename).fileName().toUtf8())) {
+        return;
+    }
+    if (QFileInfo::exists(corePath())) {
+        qDebug() << "Core already cached, returning early";
+        finish(corePath());
+        return;
+    }
+    Q_EMIT excavating(corePath());
+
+    m_extractionFd = openLock(m_entryPath + '/'_L1 + EXTRACTION_LOCK);
+    if (m_extractionFd < 0) {
+        Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", QString::fromLocal8Bit(strerror(errno))));
+        return;
+    }
+    if (flockRetrying(m_extractionFd, LOCK_EX | LOCK_NB) == 0) {
+        excavateLocked(coredumpFilename);
+        return;
+    }
+    if (errno != EWOULDBLOCK) {
+        const auto error = QString::fromLocal8Bit(strerror(errno));
+        unlockExtraction();
+        Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", error));
+        return;
+    }
+    waitForExtraction(coredumpFilename);
+}
+
+void AutomaticCoredumpExcavator::waitForExtraction(const QString &coredumpFilename)
+{
+    qDebug() << "Core is being excavated by someone else, waiting for them";
+    // The lock is on the open file description, a dup'd fd shares it. Should we get destroyed while waiting, closing
+    // the dup releases the lock again.
+    const int fd = fcntl(m_extractionFd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        unlockExtraction();
+        Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", QString::fromLocal8Bit(strerror(errno))));
         return;
     }
-    if (!coreFile->open(QFile::WriteOnly, QFile::ReadUser | QFile::WriteUser)) {
-        qWarning() << "Failed to open coreFileTarget" << coreFileTarget << coreFile->errorString();
-        Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", coreFile->errorString()));
+    auto watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher, coredumpFilename] {
+        watcher->deleteLater();
+        if (watcher->result() != 0) {
+            unlockExtraction();
+            Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system",
+                                "Failed to open core file: %1",
+                                QString::fromLocal8Bit(strerror(watcher->result()))));
+            return;
+        }
+        if (QFileInfo::exists(corePath())) {
+            unlockExtraction();
+            finish(corePath());
+            return;
+        }
+        // The other excavation failed. Have a go ourselves.
+        excavateLocked(coredumpFilename);
+    });
+    watcher->setFuture(QtConcurrent::run([fd] {
+        const int ret = flockRetrying(fd, LOCK_EX) == 0 ? 0 : errno;
+        close(fd);
+        return ret;
+    }));
+}
+
+void AutomaticCoredumpExcavator::excavateLocked(const QString &coredumpFilename)
+{
+    if (QFileInfo::exists(corePath())) { // published while we acquired the lock
+        unlockExtraction();
+        finish(corePath());
         return;
     }
 
-    if (!coredumpFileInfo.exists()) {
+    const auto coredumpFileInfo = QFileInfo(coredumpFilename);
+    if (m_journalCursor.isEmpty() && !coredumpFileInfo.exists()) {
         qWarning() << "Coredump file does not exist" << coredumpFilename;
+        unlockExtraction();
         Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Coredump file does not exist: %1", coredumpFilename));
         return;
     }
 
-    if (coredumpFileInfo.isReadable()) {
+    // The size of cores in the journal is unknown until they are out, they always go to disk.
+    const auto target = m_freeRAM && m_journalCursor.isEmpty() ? CorePlacement::choose(coredumpFilename, m_freeRAM) : CorePlacement::Target::Disk;
+    const auto targetPath = target == CorePlacement::Target::Memory ? memoryCorePath() : corePath();
+
+    // Extract into a temporary file and only rename it into place once complete. Nobody ever sees a partial core.
+    auto partialCore = std::make_shared<QTemporaryFile>(targetPath + u".XXXXXX"_s);
+    if (!partialCore->open()) {
+        qWarning() << "Failed to open core file" << partialCore->fileName() << partialCore->errorString();
+        unlockExtraction();
+        Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", partialCore->errorString()));
+        return;
+    }
+    auto publish = [this, partialCore, targetPath] {
+        partialCore->setAutoRemove(false);
+        if (::rename(QFile::encodeName(partialCore->fileName()).constData(), QFile::encodeName(targetPath).constData()) != 0) {
+            const auto error = QString::fromLocal8Bit(strerror(errno));
+            partialCore->remove();
+            unlockExtraction();
+            Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", error));
+            return;
+        }
+        if (targetPath != corePath()) {
+            // In memory. Link it from the entry, again by renaming into place.
+            const auto link = QFile::encodeName(corePath() + u".link"_s);
+            ::unlink(link.constData());
+            if (::symlink(QFile::encodeName(targetPath).constData(), link.constData()) != 0
+                || ::rename(link.constData(), QFile::encodeName(corePath()).constData()) != 0) {
+                const auto error = QString::fromLocal8Bit(strerror(errno));
+                QFile::remove(targetPath);
+                unlockExtraction();
+                Q_EMIT failed(i18nc("diagnostic error. %1 is the specific error message from the system", "Failed to open core file: %1", error));
+                return;
+            }
+        }
+        // Build the module table while still holding the lock, so waiters get it right away as well.
+        finish(corePath());
+    };
+
+    if (!m_journalCursor.isEmpty()) {
+        // Only the fd is touched from the worker thread, never the QFile.
+        auto watcher = new QFutureWatcher<bool>(this);
+        connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, publish] {
+            watcher->deleteLater();
+            if (!watcher->result()) {
+                unlockExtraction();
+                Q_EMIT failed(i18nc("diagnostic error", "Failed to read the core from the journal"));
+                return;
+            }
+            publish();
+        });
+        watcher->setFuture(QtConcurrent::run([cursor = m_journalCursor, fd = partialCore->handle()] {
+            return JournalEntry::streamCore(cursor, fd);
+        }));
+    } else if (coredumpFileInfo.isReadable()) {
         auto excavator = new CoredumpExcavator(this);
-        connect(excavator, &CoredumpExcavator::excavated, this, [this, coreFileTarget](int exitCode) {
+        connect(excavator, &CoredumpExcavator::excavated, this, [this, excavator, publish](int exitCode) {
+            excavator->deleteLater();
             if (exitCode != 0) {
                 qWarning() << "Failed to excavate core from file:" << exitCode;
+                unlockExtraction();
                 Q_EMIT failed(
                     i18nc("diagnostic error. %1 is the numeric exit code", "Core file extraction process failed with code: %1", QString::number(exitCode)));
                 return;
             }
-            Q_EMIT excavated(coreFileTarget);
+            publish();
         });
         // Only has one signal!
-        excavator->excavateFromTo(coredumpFilename, coreFile);
+        excavator->excavateFromTo(coredumpFilename, partialCore);
     } else {
         auto msg = QDBusMessage::createMethodCall("org.kde.drkonqi"_L1, "/"_L1, "org.kde.drkonqi"_L1, "saveCoreToFile"_L1);
 
-        msg << coredumpFileInfo.fileName() << QVariant::fromValue(QDBusUnixFileDescriptor(coreFile->handle()));
+        msg << coredumpFileInfo.fileName() << QVariant::fromValue(QDBusUnixFileDescriptor(partialCore->handle()));
         constexpr auto timeout = std::chrono::milliseconds(5min).count();
         auto watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(msg, timeout));
-        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, coreFileTarget] {
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, partialCore, publish] {
             watcher->deleteLater();
             QDBusReply<void> reply = *watcher;
-            qWarning() << reply.isValid() << reply.error();
             if (!reply.isValid()) {
-                m_coreDir = nullptr;
                 qWarning() << "Failed to excavate core as admin:" << reply.error();
+                unlockExtraction();
                 Q_EMIT failed(i18nc("diagnostic error. %1 is a dbus error from a polkit helper",
                                     "Elevated core file extraction process failed: %1",
                                     reply.error().message()));
                 return;
             }
-            Q_EMIT excavated(coreFileTarget);
+            // The helper wrote through its own fd, make sure our QFile doesn't think it knows better.
+            partialCore->close();
+            publish();
         });
     }
 }
 
+void AutomaticCoredumpExcavator::finish(const QString &corePath)
+{
+    // Holes are left where the core is all zeroes (see NativeExcavator), say how much that saved.
+    if (struct stat info{}; stat(QFile::encodeName(corePath).constData(), &info) == 0) {
+        const qint64 logicalSize = info.st_size;
+        const qint64 physicalSize = qint64(info.st_blocks) * 512; // st_blocks is always in units of 512
+        const QLocale locale = QLocale::system();
+        qDebug() << "Core" << corePath << "is" << locale.formattedDataSize(logicalSize) << "large and occupies"
+                 << locale.formattedDataSize(physicalSize) << "on disk, saving" << locale.formattedDataSize(std::max<qint64>(logicalSize - physicalSize, 0));
+    }
+
+    // Resolve the modules once while the core is hot in the page cache. Retries and other consumers of the same core
+    // get the table for free. Reading the notes means paging in the core, keep that off our thread.
+    auto watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, corePath] {
+        watcher->deleteLater();
+        if (watcher->result().isEmpty()) {
+            qWarning() << "Failed to build module table, the debugger will have to resolve modules itself";
+        }
+        unlockExtraction();
+        Q_EMIT excavated(corePath);
+    });
+    watcher->setFuture(QtConcurrent::run([corePath] {
+        return CoreModules::ensureTable(corePath);
+    }));
+}
+
 #include "moc_automaticcoredumpexcavator.cpp"
@@ -2,21 +2,59 @@
 
 #pragma once
 
+#include <optional>
+
 #include <QObject>
-#include <QTemporaryDir>
 
+// Excavates cores into a cache shared by all users (drkonqi, drkonqi-coredump-gui, retries...).
+// Every core gets an entry directory keyed by its COREDUMP_FILENAME (or journal cursor for cores stored in the journal,
+// their file name is the synthesized /dev/null). Only one user extracts a given core, the others
+// wait for the extraction to be published. Users hold a shared lock on the entry for as long as they use it
+// (i.e. the lifetime of the excavator), the cleanup only evicts entries nobody holds. The last user to leave throws
+// away a core placed in memory.
+// Cores may get placed in memory instead, see CorePlacement.
 class AutomaticCoredumpExcavator : public QObject
 {
     Q_OBJECT
 public:
     using QObject::QObject;
-    void excavateFrom(const QString &coredumpFilename);
+    ~AutomaticCoredumpExcavator() override;
+    // journalCursor is the crash's journal entry, only required for cores stored in the journal (Storage=journal).
+    void excavateFrom(const QString &coredumpFilename, const QByteArray &journalCursor = {});
+
+    // Free memory as per MemoryFence. Enables placing the core in memory, without it the core always goes to disk.
+    void setFreeRAM(std::optional<quint64> freeRAM);
+    [[nodiscard]] bool isInMemory() const;
+    // Moves a core placed in memory to disk. The core path stays the same. Users that have the core open keep the
+    // memory copy alive until they close it.
+    void moveToDisk();
+
+    // Root of the shared cache (drkonqi-coredump-cleanup must agree!)
+    [[nodiscard]] static QString cacheLocation();
 
 Q_SIGNALS:
     void failed(const QString &context);
+    // The core is not cached and will appear at corePath once excavated is emitted. Not emitted for cached cores.
+    void excavating(const QString &corePath);
     // WARNING: the corepath is only valid as long as the excavator exists!
+    // Also see CoreModules::tablePath for the module table cached beside the core.
     void excavated(const QString &corePath);
+    void movedToDisk();
 
 private:
-    std::unique_ptr<QTemporaryDir> m_coreDir;
+    [[nodiscard]] bool acquireEntry(const QByteArray &entryName);
+    void releaseEntry();
+    void waitForExtraction(const QString &coredumpFilename);
+    void excavateLocked(const QString &coredumpFilename);
+    void unlockExtraction();
+    void finish(const QString &corePath);
+    [[nodiscard]] QString corePath() const;
+    [[nodiscard]] QString memoryCorePath() const;
+
+    QString m_entryPath;
+    QByteArray m_journalCursor;
+    int m_usersFd = -1; // shared lock for as long as we use the entry
+    int m_extractionFd = -1; // exclusive lock while extracting
+    std::optional<quint64> m_freeRAM;
+    bool m_movingToDisk = false;
 };
@@ -2,13 +2,61 @@
 
 #include "coredumpexcavator.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
 #include <QDebug>
 #include <QFile>
+#include <QFutureWatcher>
 #include <QProcess>
+#include <QtConcurrentRun>
+
+#include "nativeexcavator.h"
 
 using namespace Qt::StringLiterals;
 
 void CoredumpExcavator::excavateFromTo(const QString &coreFile, const std::shared_ptr<QFile> &coreFileTarget)
+{
+    // Only the fd is touched from the worker thread, never the QFile.
+    coreFileTarget->flush();
+    const int targetFd = coreFileTarget->handle();
+    // The native excavation needs to seek and truncate. Pipes and such (e.g. passed in over D-Bus) get streamed into.
+    if (struct stat info{}; fstat(targetFd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        excavateWithCoredumpctl(coreFile, coreFileTarget);
+        return;
+    }
+
+    qDebug() << "excavating natively" << coreFile;
+    auto watcher = new QFutureWatcher<NativeExcavator::Result>(this);
+    connect(watcher, &QFutureWatcher<NativeExcavator::Result>::finished, this, [this, watcher, coreFile, coreFileTarget, targetFd] {
+        watcher->deleteLater();
+        switch (watcher->result()) {
+        case NativeExcavator::Result::Excavated:
+            qDebug() << "Core dump excavation complete";
+            Q_EMIT excavated(0);
+            return;
+        case NativeExcavator::Result::Failed:
+            // Start over, coredumpctl may know better (e.g. a compression we don't recognize by name).
+            if (ftruncate(targetFd, 0) != 0 || lseek(targetFd, 0, SEEK_SET) != 0) {
+                qWarning() << "Failed to reset core target" << strerror(errno);
+                Q_EMIT excavated(1);
+                return;
+            }
+            break;
+        case NativeExcavator::Result::Unsupported:
+            break;
+        }
+        excavateWithCoredumpctl(coreFile, coreFileTarget);
+    });
+    watcher->setFuture(QtConcurrent::run([coreFile, targetFd] {
+        return NativeExcavator::excavate(coreFile, targetFd);
+    }));
+}
+
+void CoredumpExcavator::excavateWithCoredumpctl(const QString &coreFile, const std::shared_ptr<QFile> &coreFileTarget)
 {
     auto proc = new QProcess(this);
     proc->setProcessChannelMode(QProcess::ForwardedErrorChannel); // stdout goes to file
@@ -16,10 +64,15 @@ void CoredumpExcavator::excavateFromTo(const QString &coreFile, const std::share
     proc->setArguments({"dump"_L1, "COREDUMP_FILENAME=%1"_L1.arg(coreFile)});
     qDebug() << "excavating" << proc->arguments();
     connect(proc, &QProcess::readyReadStandardOutput, coreFileTarget.get(), [proc, coreFileTarget] {
-        auto data = proc->readAllStandardOutput();
-        while (data.size() != 0) {
-            auto written = coreFileTarget->write(data);
-            data = data.mid(written);
+        const auto data = proc->readAllStandardOutput();
+        for (qsizetype offset = 0; offset < data.size();) {
+            const auto written = coreFileTarget->write(data.constData() + offset, data.size() - offset);
+            if (written < 0) {
+                qWarning() << "Failed to write core" << coreFileTarget->errorString();
+                proc->kill();
+                return;
+            }
+            offset += written;
         }
     });
     connect(proc, &QProcess::finished, this, [this, proc, coreFileTarget](int exitCode, QProcess::ExitStatus exitStatus) mutable {
@@ -27,7 +80,7 @@ void CoredumpExcavator::excavateFromTo(const QString &coreFile, const std::share
         proc->deleteLater();
         coreFileTarget->flush();
         Q_ASSERT(proc->readAllStandardOutput().size() == 0);
-        Q_EMIT excavated(exitCode);
+        Q_EMIT excavated(exitStatus == QProcess::NormalExit ? exitCode : 1);
     });
     proc->start();
 }
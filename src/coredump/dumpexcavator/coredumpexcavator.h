@@ -11,8 +11,12 @@ class CoredumpExcavator : public QObject
     Q_OBJECT
 public:
     using QObject::QObject;
+    // Extracts natively where possible (see NativeExcavator) and falls back to coredumpctl otherwise.
     void excavateFromTo(const QString &coreFile, const std::shared_ptr<QFile> &coreFileTarget);
 
 Q_SIGNALS:
     void excavated(int exitCode);
+
+private:
+    void excavateWithCoredumpctl(const QString &coreFile, const std::shared_ptr<QFile> &coreFileTarget);
 };
@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "coremodules.h"
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+// Don't let a broken core make us allocate silly amounts of memory.
+constexpr quint64 MAX_NOTE_SIZE = 64ULL * 1024 * 1024;
+
+struct Note {
+    QByteArray name;
+    Elf64_Word type;
+    QByteArray desc;
+};
+
+template<typename T>
+[[nodiscard]] std::optional<T> readStruct(const QByteArray &data, qsizetype offset)
+{
+    if (offset < 0 || offset + qsizetype(sizeof(T)) > data.size()) {
+        return std::nullopt;
+    }
+    T ret;
+    std::memcpy(&ret, data.constData() + offset, sizeof(T));
+    return ret;
+}
+
+[[nodiscard]] constexpr quint64 alignUp(quint64 value, quint64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+[[nodiscard]] QList<Note> parseNotes(const QByteArray &data, quint64 alignment)
+{
+    // Notes are either 4 or 8 byte aligned. Anything else is treated as 4 same as libelf does.
+    alignment = alignment == 8 ? 8 : 4;
+
+    QList<Note> notes;
+    qsizetype offset = 0;
+    while (const auto header = readStruct<Elf64_Nhdr>(data, offset)) {
+        const auto nameOffset = offset + qsizetype(sizeof(Elf64_Nhdr));
+        const auto descOffset = qsizetype(alignUp(nameOffset + header->n_namesz, alignment));
+        const auto nextOffset = qsizetype(alignUp(descOffset + header->n_descsz, alignment));
+        if (descOffset + qsizetype(header->n_descsz) > data.size()) {
+            break;
+        }
+        // The name is NUL terminated, the size includes the terminator.
+        auto name = data.mid(nameOffset, header->n_namesz);
+        if (name.endsWith('\0')) {
+            name.chop(1);
+        }
+        notes.append({.name = name, .type = header->n_type, .desc = data.mid(descOffset, header->n_descsz)});
+        offset = nextOffset;
+    }
+    return notes;
+}
+
+struct Mapping {
+    quint64 start;
+    quint64 end;
+    quint64 fileOffset;
+    QString file;
+};
+
+// NT_FILE descriptor: count, page size, count x (start, end, page offset), count x NUL terminated file name.
+[[nodiscard]] QList<Mapping> parseFileNote(const QByteArray &desc)
+{
+    const auto count = readStruct<quint64>(desc, 0);
+    const auto pageSize = readStruct<quint64>(desc, sizeof(quint64));
+    if (!count || !pageSize || *count > quint64(desc.size()) / (3 * sizeof(quint64))) {
+        return {};
+    }
+
+    QList<Mapping> mappings;
+    mappings.reserve(qsizetype(*count));
+    qsizetype offset = 2 * sizeof(quint64);
+    for (quint64 i = 0; i < *count; ++i) {
+        const auto start = readStruct<quint64>(desc, offset);
+        const auto end = readStruct<quint64>(desc, offset + qsizetype(sizeof(quint64)));
+        const auto pageOffset = readStruct<quint64>(desc, offset + qsizetype(2 * sizeof(quint64)));
+        if (!start || !end || !pageOffset) {
+            return {};
+        }
+        mappings.append({.start = *start, .end = *end, .fileOffset = *pageOffset * *pageSize, .file = {}});
+        offset += 3 * sizeof(quint64);
+    }
+    for (auto &mapping : mappings) {
+        const auto terminator = desc.indexOf('\0', offset);
+        if (terminator < 0) {
+            return {};
+        }
+        mapping.file = QString::fromUtf8(desc.mid(offset, terminator - offset));
+        offset = terminator + 1;
+    }
+    return mappings;
+}
+
+class CoreReader
+{
+public:
+    explicit CoreReader(const QString &path)
+        : m_file(path)
+    {
+    }
+
+    [[nodiscard]] bool open()
+    {
+        if (!m_file.open(QFile::ReadOnly)) {
+            qWarning() << "Failed to open core" << m_file.fileName() << m_file.errorString();
+            return false;
+        }
+        const auto header = readStruct<Elf64_Ehdr>(readAt(0, sizeof(Elf64_Ehdr)), 0);
+        if (!header || std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0) {
+            qWarning() << "Not an ELF file" << m_file.fileName();
+            return false;
+        }
+        if (header->e_ident[EI_CLASS] != ELFCLASS64 || header->e_type != ET_CORE || header->e_phentsize != sizeof(Elf64_Phdr)) {
+            qWarning() << "Not a 64 bit ELF core" << m_file.fileName();
+            return false;
+        }
+        const auto table = readAt(header->e_phoff, quint64(header->e_phnum) * sizeof(Elf64_Phdr));
+        for (qsizetype offset = 0; const auto phdr = readStruct<Elf64_Phdr>(table, offset); offset += sizeof(Elf64_Phdr)) {
+            m_programHeaders.append(*phdr);
+        }
+        return !m_programHeaders.isEmpty();
+    }
+
+    [[nodiscard]] QList<Note> coreNotes()
+    {
+        QList<Note> notes;
+        for (const auto &phdr : std::as_const(m_programHeaders)) {
+            if (phdr.p_type == PT_NOTE && phdr.p_filesz <= MAX_NOTE_SIZE) {
+                notes += parseNotes(readAt(phdr.p_offset, phdr.p_filesz), phdr.p_align);
+            }
+        }
+        return notes;
+    }
+
+    // Reads memory of the crashed process. Only succeeds if the requested range was actually dumped into the core.
+    [[nodiscard]] QByteArray readMemory(quint64 address, quint64 size)
+    {
+        for (const auto &phdr : std::as_const(m_programHeaders)) {
+            if (phdr.p_type != PT_LOAD || address < phdr.p_vaddr || address + size > phdr.p_vaddr + phdr.p_filesz) {
+                continue;
+            }
+            return readAt(phdr.p_offset + (address - phdr.p_vaddr), size);
+        }
+        return {};
+    }
+
+    // Same approach as gdb and eu-unstrip: the kernel dumps the first page of every ELF mapping, which contains the
+    // ELF and program headers. The build-id note is usually found in that page too.
+    [[nodiscard]] QByteArray buildId(const Mapping &mapping)
+    {
+        const auto header = readStruct<Elf64_Ehdr>(readMemory(mapping.start, sizeof(Elf64_Ehdr)), 0);
+        if (!header || std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0) {
+            return {}; // not an ELF (e.g. a font or locale archive)
+        }
+        if (header->e_ident[EI_CLASS] != ELFCLASS64 || header->e_phentsize != sizeof(Elf64_Phdr) || header->e_phnum == 0) {
+            return {};
+        }
+
+        const auto table = readMemory(mapping.start + header->e_phoff, quint64(header->e_phnum) * sizeof(Elf64_Phdr));
+        QList<Elf64_Phdr> programHeaders;
+        for (qsizetype offset = 0; const auto phdr = readStruct<Elf64_Phdr>(table, offset); offset += sizeof(Elf64_Phdr)) {
+            programHeaders.append(*phdr);
+        }
+
+        // The load bias is relative to the first segment, which is the one we've found the headers in.
+        const auto firstLoad = std::ranges::find_if(programHeaders, [](const Elf64_Phdr &phdr) {
+            return phdr.p_type == PT_LOAD;
+        });
+        if (firstLoad == programHeaders.cend()) {
+            return {};
+        }
+        const auto bias = mapping.start - (firstLoad->p_vaddr - firstLoad->p_offset);
+
+        for (const auto &phdr : std::as_const(programHeaders)) {
+            if (phdr.p_type != PT_NOTE || phdr.p_filesz > MAX_NOTE_SIZE) {
+                continue;
+            }
+            for (const auto &note : parseNotes(readMemory(bias + phdr.p_vaddr, phdr.p_filesz), phdr.p_align)) {
+                if (note.type == NT_GNU_BUILD_ID && note.name == "GNU") {
+                    return note.desc.toHex();
+                }
+            }
+        }
+        return {};
+    }
+
+private:
+    [[nodiscard]] QByteArray readAt(quint64 offset, quint64 size)
+    {
+        if (!m_file.seek(qint64(offset))) {
+            return {};
+        }
+        return m_file.read(qint64(size));
+    }
+
+    QFile m_file;
+    QList<Elf64_Phdr> m_programHeaders;
+};
+} // namespace
+
+std::optional<QList<CoreModule>> CoreModules::read(const QString &corePath)
+{
+    CoreReader reader(corePath);
+    if (!reader.open()) {
+        return std::nullopt;
+    }
+
+    QList<Mapping> mappings;
+    for (const auto &note : reader.coreNotes()) {
+        if (note.type == NT_FILE && note.name == "CORE") {
+            mappings = parseFileNote(note.desc);
+            break;
+        }
+    }
+    if (mappings.isEmpty()) {
+        qWarning() << "No file mappings found in core" << corePath;
+        return std::nullopt;
+    }
+
+    // Files are usually mapped multiple times (text, data, etc.). The module spans all of them.
+    QList<CoreModule> modules;
+    QHash<QString, qsizetype> moduleIndex;
+    for (const auto &mapping : std::as_const(mappings)) {
+        if (auto it = moduleIndex.constFind(mapping.file); it != moduleIndex.cend()) {
+            auto &module = modules[it.value()];
+            module.start = std::min(module.start, mapping.start);
+            module.end = std::max(module.end, mapping.end);
+            if (module.buildId.isEmpty() && mapping.fileOffset == 0) {
+                module.buildId = reader.buildId(mapping);
+            }
+            continue;
+        }
+        moduleIndex.insert(mapping.file, modules.size());
+        modules.append({
+            .file = mapping.file,
+            .buildId = mapping.fileOffset == 0 ? reader.buildId(mapping) : QByteArray(),
+            .start = mapping.start,
+            .end = mapping.end,
+        });
+    }
+
+    // Without a build id the module is of no use to the preamble.
+    modules.removeIf([](const CoreModule &module) {
+        return module.buildId.isEmpty();
+    });
+    return modules;
+}
+
+QByteArray CoreModules::toJson(const QList<CoreModule> &modules)
+{
+    QJsonArray array;
+    for (const auto &module : modules) {
+        array.append(QJsonObject{
+            {u"file"_s, module.file},
+            {u"build_id"_s, QString::fromLatin1(module.buildId)},
+            {u"address"_s, u"0x%1"_s.arg(module.start, 0, 16)},
+            {u"length"_s, qint64(module.end - module.start)},
+        });
+    }
+    return QJsonDocument(array).toJson(QJsonDocument::Compact);
+}
+
+QString CoreModules::tablePath(const QString &corePath)
+{
+    return corePath + ".modules.json"_L1;
+}
+
+QString CoreModules::ensureTable(const QString &corePath)
+{
+    const auto path = tablePath(corePath);
+    if (QFileInfo::exists(path)) {
+        return path;
+    }
+
+    const auto modules = read(corePath);
+    if (!modules) {
+        return {};
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "Failed to open module table for writing" << path << file.errorString();
+        return {};
+    }
+    file.write(toJson(modules.value()));
+    if (!file.commit()) {
+        qWarning() << "Failed to write module table" << path << file.errorString();
+        return {};
+    }
+    return path;
+}
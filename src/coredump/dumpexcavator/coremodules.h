@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <optional>
+
+#include <QList>
+#include <QString>
+
+// A module (executable or shared object) that was mapped into the crashed process.
+struct CoreModule {
+    QString file;
+    QByteArray buildId; // hex encoded
+    quint64 start = 0;
+    quint64 end = 0;
+};
+
+// Module table of a core. This is what the gdb preamble would otherwise resolve via gdb.Corefile or eu-unstrip on every run.
+namespace CoreModules
+{
+// Reads the table from the NT_FILE note and the build-id notes of the modules as dumped into the core.
+// Only 64 bit ELF cores are supported. Returns nullopt when the core cannot be parsed.
+[[nodiscard]] std::optional<QList<CoreModule>> read(const QString &corePath);
+[[nodiscard]] QByteArray toJson(const QList<CoreModule> &modules);
+// Where the table of a given core gets cached. It lives beside the core and shares its lifetime.
+[[nodiscard]] QString tablePath(const QString &corePath);
+// Reads the table and caches it beside the core, unless it is already cached.
+// Returns the path of the table or an empty string when no table could be written.
+[[nodiscard]] QString ensureTable(const QString &corePath);
+} // namespace CoreModules
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "coreplacement.h"
+
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "nativeexcavator.h"
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr quint64 GiB = 1024ULL * 1024 * 1024;
+// After placing the core there must still be enough free memory for the debugger to run in MemoryFence's spacious
+// tier. MemoryFence::applyProperties sets aside 1 GiB of breathing room and then wants more than 12 whole GiB, i.e. at
+// least 13 GiB. Keep in sync!
+constexpr quint64 SPACIOUS_FREE_RAM = 14 * GiB;
+// The runtime directory is shared with everything else in the session and commonly capped at a fraction of the RAM.
+// Don't take more than half of what is left.
+constexpr quint64 MEMORY_LOCATION_SHARE = 2;
+} // namespace
+
+QString CorePlacement::memoryLocation()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + u"/drkonqi/cores/"_s;
+}
+
+CorePlacement::Target CorePlacement::choose(std::optional<quint64> coreSize, std::optional<quint64> freeRAM, std::optional<quint64> memoryLocationFree)
+{
+    if (!coreSize || !freeRAM || !memoryLocationFree) {
+        return Target::Disk;
+    }
+    if (freeRAM.value() < coreSize.value() || freeRAM.value() - coreSize.value() < SPACIOUS_FREE_RAM) {
+        return Target::Disk;
+    }
+    if (coreSize.value() > memoryLocationFree.value() / MEMORY_LOCATION_SHARE) {
+        return Target::Disk;
+    }
+    return Target::Memory;
+}
+
+CorePlacement::Target CorePlacement::choose(const QString &coredumpFilename, std::optional<quint64> freeRAM)
+{
+    if (!freeRAM) {
+        return Target::Disk; // don't bother looking at the core
+    }
+
+    const auto coreSize = NativeExcavator::uncompressedSize(coredumpFilename);
+    const auto memoryLocationFree = []() -> std::optional<quint64> {
+        const auto location = memoryLocation();
+        if (!QDir().mkpath(location)) {
+            return std::nullopt;
+        }
+        struct statvfs info{};
+        if (statvfs(QFile::encodeName(location).constData(), &info) != 0) {
+            return std::nullopt;
+        }
+        return quint64(info.f_bavail) * info.f_frsize;
+    }();
+    const auto target = choose(coreSize, freeRAM, memoryLocationFree);
+    qDebug() << "Core placement" << (target == Target::Memory ? "memory" : "disk") << "for core of size" << coreSize << "with free RAM" << freeRAM
+             << "and free runtime space" << memoryLocationFree;
+    return target;
+}
+
+quint64 CorePlacement::memoryUsage()
+{
+    quint64 usage = 0;
+    const auto entries = QDir(memoryLocation()).entryInfoList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
+    for (const auto &entry : entries) {
+        if (struct stat info{}; lstat(QFile::encodeName(entry.filePath()).constData(), &info) == 0) {
+            usage += quint64(info.st_blocks) * 512; // cores have holes, only count what is actually backed by memory
+        }
+    }
+    return usage;
+}
+
+bool CorePlacement::isInMemory(const QString &corePath)
+{
+    const auto target = QFileInfo(corePath).canonicalFilePath();
+    const auto location = QFileInfo(memoryLocation()).canonicalFilePath();
+    return !target.isEmpty() && !location.isEmpty() && target.startsWith(location + '/'_L1);
+}
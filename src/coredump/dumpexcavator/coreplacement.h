@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <optional>
+
+#include <QString>
+
+// gdb reads cores all over the place, from tmpfs that is a lot quicker than from disk. But a core in tmpfs is memory
+// the debugger doesn't get to use, so we only go there when there is plenty to spare.
+// Cores placed in memory live in memoryLocation() and are symlinked from their cache entry, the core path that
+// consumers see is the same either way.
+namespace CorePlacement
+{
+enum class Target {
+    Disk,
+    Memory,
+};
+
+// Root of the cores placed in memory (drkonqi-coredump-cleanup must agree!). Files are named after their cache entry.
+[[nodiscard]] QString memoryLocation();
+
+// Pure policy. coreSize is the excavated size, freeRAM what MemoryFence considers free, memoryLocationFree the space
+// left in memoryLocation(). Anything unknown means disk.
+[[nodiscard]] Target choose(std::optional<quint64> coreSize, std::optional<quint64> freeRAM, std::optional<quint64> memoryLocationFree);
+// Same but looks up the core size and free space itself.
+[[nodiscard]] Target choose(const QString &coredumpFilename, std::optional<quint64> freeRAM);
+
+// Bytes occupied by cores in memory. They show up as cache in the memory statistics but can't be reclaimed.
+[[nodiscard]] quint64 memoryUsage();
+
+// Whether the core at corePath (usually the cache entry's symlink) resolves into memoryLocation().
+[[nodiscard]] bool isInMemory(const QString &corePath);
+} // namespace CorePlacement
@@ -0,0 +1,831 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "nativeexcavator.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <QDebug>
+#include <QFile>
+#include <QScopeGuard>
+#include <QtEndian>
+
+#if defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(HAVE_LZMA)
+#include <lzma.h>
+#endif
+#if defined(HAVE_LZ4)
+#include <lz4frame.h>
+#endif
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+// Large buffers keep the number of syscalls down, cores are commonly in the gigabytes.
+constexpr size_t BUFFER_ALIGNMENT = 4096;
+constexpr size_t INPUT_BUFFER_SIZE = 1024 * 1024;
+constexpr size_t OUTPUT_BUFFER_SIZE = 4 * 1024 * 1024;
+// Granularity of hole detection. Filesystems allocate in blocks of (at least) this size.
+constexpr size_t SPARSE_BLOCK_SIZE = 4096;
+
+enum class Compression {
+    None,
+    Zstd,
+    Xz,
+    Lz4,
+};
+
+struct FreeDeleter {
+    void operator()(char *ptr) const
+    {
+        std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+};
+using Buffer = std::unique_ptr<char, FreeDeleter>;
+
+[[nodiscard]] Buffer makeBuffer(size_t size)
+{
+    return Buffer(static_cast<char *>(std::aligned_alloc(BUFFER_ALIGNMENT, size)));
+}
+
+[[nodiscard]] Compression compressionOf(const QString &coreFile)
+{
+    // systemd-coredump names the files after the compression (core.<comm>.<uid>.<boot>.<pid>.<time>.zst)
+    if (coreFile.endsWith(".zst"_L1)) {
+        return Compression::Zstd;
+    }
+    if (coreFile.endsWith(".xz"_L1)) {
+        return Compression::Xz;
+    }
+    if (coreFile.endsWith(".lz4"_L1)) {
+        return Compression::Lz4;
+    }
+    return Compression::None;
+}
+
+[[nodiscard]] constexpr bool isSupported(Compression compression)
+{
+    switch (compression) {
+    case Compression::None:
+        return true;
+    case Compression::Zstd:
+#if defined(HAVE_ZSTD)
+        return true;
+#else
+        return false;
+#endif
+    case Compression::Xz:
+#if defined(HAVE_LZMA)
+        return true;
+#else
+        return false;
+#endif
+    case Compression::Lz4:
+#if defined(HAVE_LZ4)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+// Writes sequentially but leaves holes where entire blocks are zero. Cores of large processes are mostly unused heap,
+// guard pages and such, no need to spend disk and write time on that.
+// The target must be empty beyond the start position, holes read back as whatever was there before.
+class SparseWriter
+{
+public:
+    explicit SparseWriter(int fd)
+        : SparseWriter(fd, lseek(fd, 0, SEEK_CUR))
+    {
+    }
+
+    // Writes at the given offset, independent of the fd's position. Multiple writers may work on the same fd
+    // so long as their ranges don't overlap.
+    SparseWriter(int fd, off_t offset)
+        : m_fd(fd)
+        , m_offset(offset)
+    {
+    }
+
+    [[nodiscard]] off_t offset() const
+    {
+        return m_offset + off_t(m_tailSize);
+    }
+
+    [[nodiscard]] bool write(const char *data, size_t size)
+    {
+        if (m_offset < 0) {
+            return false;
+        }
+        // Complete a block started by a previous write first. Blocks are aligned to the file offset.
+        if (m_tailSize > 0) {
+            const auto take = std::min(size, SPARSE_BLOCK_SIZE - m_tailSize);
+            std::memcpy(m_tail.data() + m_tailSize, data, take);
+            m_tailSize += take;
+            data += take;
+            size -= take;
+            if (m_tailSize < SPARSE_BLOCK_SIZE) {
+                return true;
+            }
+            m_tailSize = 0;
+            if (!writeBlocks(m_tail.data(), SPARSE_BLOCK_SIZE)) {
+                return false;
+            }
+        }
+        const auto blocksSize = size - (size % SPARSE_BLOCK_SIZE);
+        if (!writeBlocks(data, blocksSize)) {
+            return false;
+        }
+        m_tailSize = size - blocksSize;
+        std::memcpy(m_tail.data(), data + blocksSize, m_tailSize);
+        return true;
+    }
+
+    // Leaves a hole of the given size.
+    [[nodiscard]] bool skip(size_t size)
+    {
+        if (!flushTail()) {
+            return false;
+        }
+        m_offset += off_t(size);
+        return true;
+    }
+
+    // Copies a range of another file in-kernel. Returns false with errno set when that isn't possible.
+    [[nodiscard]] bool copyFileRange(int sourceFd, off_t sourceOffset, size_t size)
+    {
+        if (!flushTail()) {
+            return false;
+        }
+        while (size > 0) {
+            const auto copied = copy_file_range(sourceFd, &sourceOffset, m_fd, &m_offset, size, 0);
+            if (copied < 0 && errno == EINTR) {
+                continue;
+            }
+            if (copied <= 0) {
+                if (copied == 0) {
+                    errno = EIO; // source shrank under us
+                }
+                return false;
+            }
+            size -= copied;
+        }
+        return true;
+    }
+
+    // Writes out the partial block, if any.
+    [[nodiscard]] bool flush()
+    {
+        return flushTail();
+    }
+
+    // Flushes the partial block and makes sure trailing holes are accounted for in the file size.
+    [[nodiscard]] bool finish()
+    {
+        if (!flushTail()) {
+            return false;
+        }
+        struct stat info{};
+        if (fstat(m_fd, &info) != 0) {
+            return false;
+        }
+        if (info.st_size < m_offset && ftruncate(m_fd, m_offset) != 0) {
+            qWarning() << "Failed to extend core:" << strerror(errno);
+            return false;
+        }
+        // Leave the position at the end like a plain sequential write would.
+        return lseek(m_fd, m_offset, SEEK_SET) == m_offset;
+    }
+
+private:
+    [[nodiscard]] static bool isZero(const char *data, size_t size)
+    {
+        static const std::array<char, SPARSE_BLOCK_SIZE> zeroes{};
+        return std::memcmp(data, zeroes.data(), size) == 0;
+    }
+
+    [[nodiscard]] bool flushTail()
+    {
+        const auto size = std::exchange(m_tailSize, 0);
+        if (size == 0 || isZero(m_tail.data(), size)) {
+            m_offset += off_t(size);
+            return true;
+        }
+        return writeAt(m_tail.data(), size);
+    }
+
+    // Writes whole blocks, coalescing consecutive data blocks into one write and skipping zero blocks.
+    [[nodiscard]] bool writeBlocks(const char *data, size_t size)
+    {
+        size_t dataStart = 0;
+        size_t dataSize = 0;
+        for (size_t offset = 0; offset < size; offset += SPARSE_BLOCK_SIZE) {
+            if (!isZero(data + offset, SPARSE_BLOCK_SIZE)) {
+                if (dataSize == 0) {
+                    dataStart = offset;
+                }
+                dataSize += SPARSE_BLOCK_SIZE;
+                continue;
+            }
+            if (dataSize > 0 && !writeAt(data + dataStart, std::exchange(dataSize, 0))) {
+                return false;
+            }
+            m_offset += off_t(SPARSE_BLOCK_SIZE);
+        }
+        return dataSize == 0 || writeAt(data + dataStart, dataSize);
+    }
+
+    [[nodiscard]] bool writeAt(const char *data, size_t size)
+    {
+        while (size > 0) {
+            const auto written = pwrite(m_fd, data, size, m_offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                qWarning() << "Failed to write core:" << strerror(errno);
+                return false;
+            }
+            data += written;
+            size -= written;
+            m_offset += written;
+        }
+        return true;
+    }
+
+    const int m_fd;
+    off_t m_offset;
+    std::array<char, SPARSE_BLOCK_SIZE> m_tail{};
+    size_t m_tailSize = 0;
+};
+
+// Returns the number of bytes read, 0 on EOF, -1 on error.
+[[nodiscard]] ssize_t readSome(int fd, char *data, size_t size)
+{
+    while (true) {
+        const auto got = read(fd, data, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            qWarning() << "Failed to read core:" << strerror(errno);
+        }
+        return got;
+    }
+}
+
+// Without a compression suffix the file should be a plain core. Make sure it is, rather than copying whatever it is.
+[[nodiscard]] bool isElf(int sourceFd)
+{
+    std::array<char, SELFMAG> magic{};
+    return pread(sourceFd, magic.data(), magic.size(), 0) == ssize_t(magic.size()) && std::memcmp(magic.data(), ELFMAG, SELFMAG) == 0;
+}
+
+[[nodiscard]] bool copyPlain(int sourceFd, int targetFd)
+{
+    struct stat info{};
+    if (fstat(sourceFd, &info) != 0) {
+        return false;
+    }
+    const off_t size = info.st_size;
+
+    // systemd-coredump writes uncompressed cores sparsely. Only copy the data segments and keep the holes.
+    // copy_file_range lets the filesystem share extents or at least copy in-kernel. It refuses some combinations
+    // (e.g. across filesystems on older kernels), in which case we read and write, detecting zero blocks ourselves.
+    SparseWriter writer(targetFd);
+    bool useCopyFileRange = true;
+    Buffer buffer;
+    off_t position = 0;
+    while (position < size) {
+        off_t dataStart = lseek(sourceFd, position, SEEK_DATA);
+        if (dataStart < 0 && errno == ENXIO) {
+            break; // only a hole left
+        }
+        off_t dataEnd = dataStart < 0 ? -1 : lseek(sourceFd, dataStart, SEEK_HOLE);
+        if (dataStart < 0 || dataEnd < 0) {
+            // No SEEK_DATA support, treat everything as data.
+            dataStart = position;
+            dataEnd = size;
+        }
+        dataEnd = std::min(dataEnd, size);
+        if (!writer.skip(dataStart - position)) {
+            return false;
+        }
+        position = dataStart;
+
+        if (useCopyFileRange) {
+            if (writer.copyFileRange(sourceFd, position, dataEnd - position)) {
+                position = dataEnd;
+                continue;
+            }
+            if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP) {
+                qWarning() << "Failed to copy core:" << strerror(errno);
+                return false;
+            }
+            useCopyFileRange = false;
+            buffer = makeBuffer(OUTPUT_BUFFER_SIZE);
+        }
+        while (position < dataEnd) {
+            const auto got = pread(sourceFd, buffer.get(), std::min<off_t>(OUTPUT_BUFFER_SIZE, dataEnd - position), position);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                qWarning() << "Failed to read core:" << (got < 0 ? strerror(errno) : "unexpected end of file");
+                return false;
+            }
+            if (!writer.write(buffer.get(), got)) {
+                return false;
+            }
+            position += got;
+        }
+    }
+    return writer.skip(size - position) && writer.finish();
+}
+
+#if defined(HAVE_ZSTD)
+struct ZstdFrame {
+    size_t compressedOffset;
+    size_t compressedSize;
+    quint64 decompressedOffset;
+    quint64 decompressedSize;
+};
+
+// Decompressed frame sizes from the seek table of the seekable format. The table lives in a skippable frame at the end.
+// https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+[[nodiscard]] std::optional<std::vector<quint64>> zstdSeekTableSizes(const char *data, size_t size)
+{
+    constexpr quint32 SEEKABLE_MAGIC = 0x8F92EAB1;
+    constexpr size_t FOOTER_SIZE = 9; // frame count, descriptor, magic
+    constexpr size_t SKIPPABLE_HEADER_SIZE = 8;
+    constexpr quint8 CHECKSUM_FLAG = 0x80;
+    if (size < FOOTER_SIZE + SKIPPABLE_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    const char *footer = data + size - FOOTER_SIZE;
+    if (qFromLittleEndian<quint32>(footer + 5) != SEEKABLE_MAGIC) {
+        return std::nullopt;
+    }
+    const auto frameCount = qFromLittleEndian<quint32>(footer);
+    const auto descriptor = quint8(footer[4]);
+    const size_t entrySize = (descriptor & CHECKSUM_FLAG) ? 12 : 8;
+    const size_t tableSize = size_t(frameCount) * entrySize;
+    if (tableSize > size - FOOTER_SIZE - SKIPPABLE_HEADER_SIZE) {
+        return std::nullopt;
+    }
+
+    std::vector<quint64> sizes;
+    sizes.reserve(frameCount);
+    for (const char *entry = footer - tableSize; entry < footer; entry += entrySize) {
+        sizes.push_back(qFromLittleEndian<quint32>(entry + 4));
+    }
+    return sizes;
+}
+
+// Where every frame's data ends up in the output. Returns nullopt when the output offsets cannot be known up front.
+[[nodiscard]] std::optional<std::vector<ZstdFrame>> zstdFrames(const char *data, size_t size)
+{
+    constexpr quint32 SKIPPABLE_MAGIC = 0x184D2A50;
+    constexpr quint32 SKIPPABLE_MAGIC_MASK = 0xFFFFFFF0;
+
+    std::vector<ZstdFrame> frames;
+    bool sizesKnown = true;
+    for (size_t offset = 0; offset < size;) {
+        const auto frameSize = ZSTD_findFrameCompressedSize(data + offset, size - offset);
+        if (ZSTD_isError(frameSize) || size - offset < sizeof(quint32)) {
+            return std::nullopt;
+        }
+        if ((qFromLittleEndian<quint32>(data + offset) & SKIPPABLE_MAGIC_MASK) == SKIPPABLE_MAGIC) {
+            offset += frameSize;
+            continue;
+        }
+        const auto contentSize = ZSTD_getFrameContentSize(data + offset, size - offset);
+        if (contentSize == ZSTD_CONTENTSIZE_ERROR) {
+            return std::nullopt;
+        }
+        sizesKnown = sizesKnown && contentSize != ZSTD_CONTENTSIZE_UNKNOWN;
+        frames.push_back({.compressedOffset = offset, .compressedSize = frameSize, .decompressedOffset = 0, .decompressedSize = contentSize});
+        offset += frameSize;
+    }
+
+    if (!sizesKnown) {
+        const auto sizes = zstdSeekTableSizes(data, size);
+        if (!sizes || sizes->size() != frames.size()) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < frames.size(); ++i) {
+            frames[i].decompressedSize = sizes->at(i);
+        }
+    }
+
+    quint64 decompressedOffset = 0;
+    for (auto &frame : frames) {
+        frame.decompressedOffset = decompressedOffset;
+        decompressedOffset += frame.decompressedSize;
+    }
+    return frames;
+}
+
+[[nodiscard]] std::optional<quint64> zstdUncompressedSize(int sourceFd)
+{
+    struct stat info{};
+    if (fstat(sourceFd, &info) != 0 || info.st_size <= 0) {
+        return std::nullopt;
+    }
+    const auto size = size_t(info.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, sourceFd, 0);
+    if (map == MAP_FAILED) {
+        return std::nullopt;
+    }
+    const auto unmap = qScopeGuard([map, size] {
+        munmap(map, size);
+    });
+    const auto frames = zstdFrames(static_cast<const char *>(map), size);
+    if (!frames || frames->empty()) {
+        return std::nullopt;
+    }
+    return frames->back().decompressedOffset + frames->back().decompressedSize;
+}
+
+// Every frame is independent, so they can be decompressed concurrently into their own range of the target.
+[[nodiscard]] bool decompressZstdFrames(const char *data, const std::vector<ZstdFrame> &frames, int targetFd)
+{
+    const off_t baseOffset = lseek(targetFd, 0, SEEK_CUR);
+    if (baseOffset < 0) {
+        return false;
+    }
+
+    std::atomic<size_t> nextFrame = 0;
+    std::atomic<bool> ok = true;
+    auto worker = [&] {
+        std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+        auto output = makeBuffer(OUTPUT_BUFFER_SIZE);
+        if (!context || !output) {
+            ok = false;
+            return;
+        }
+        for (auto index = nextFrame++; ok && index < frames.size(); index = nextFrame++) {
+            const auto &frame = frames[index];
+            const off_t frameStart = baseOffset + off_t(frame.decompressedOffset);
+            SparseWriter writer(targetFd, frameStart);
+            ZSTD_DCtx_reset(context.get(), ZSTD_reset_session_only);
+            ZSTD_inBuffer in{.src = data + frame.compressedOffset, .size = frame.compressedSize, .pos = 0};
+            size_t result = 0;
+            while (in.pos < in.size) {
+                ZSTD_outBuffer out{.dst = output.get(), .size = OUTPUT_BUFFER_SIZE, .pos = 0};
+                result = ZSTD_decompressStream(context.get(), &out, &in);
+                if (ZSTD_isError(result)) {
+                    qWarning() << "Failed to decompress zstd core frame" << index << ZSTD_getErrorName(result);
+                    ok = false;
+                    return;
+                }
+                // Never write past the frame's range, that belongs to another worker.
+                if (quint64(writer.offset() - frameStart) + out.pos > frame.decompressedSize || !writer.write(output.get(), out.pos)) {
+                    ok = false;
+                    return;
+                }
+            }
+            if (result != 0 || quint64(writer.offset() - frameStart) != frame.decompressedSize || !writer.flush()) {
+                qWarning() << "zstd core frame" << index << "is truncated or doesn't match its declared size";
+                ok = false;
+                return;
+            }
+        }
+    };
+
+    const auto threadCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, frames.size());
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker(); // this thread helps out too
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (!ok) {
+        return false;
+    }
+    SparseWriter end(targetFd, baseOffset + off_t(frames.back().decompressedOffset + frames.back().decompressedSize));
+    return end.finish();
+}
+
+[[nodiscard]] bool decompressZstd(int sourceFd, int targetFd)
+{
+    // Multiple frames (e.g. the seekable format, pzstd or concatenated frames) get decompressed in parallel.
+    // A single frame, as systemd-coredump writes it, is streamed.
+    if (struct stat info{}; fstat(sourceFd, &info) == 0 && info.st_size > 0) {
+        const auto size = size_t(info.st_size);
+        void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, sourceFd, 0);
+        if (map != MAP_FAILED) {
+            const auto unmap = qScopeGuard([map, size] {
+                munmap(map, size);
+            });
+            const auto data = static_cast<const char *>(map);
+            if (const auto frames = zstdFrames(data, size); frames && frames->size() > 1) {
+                madvise(map, size, MADV_WILLNEED);
+                return decompressZstdFrames(data, frames.value(), targetFd);
+            }
+        }
+    }
+
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    SparseWriter writer(targetFd);
+    if (!context) {
+        return false;
+    }
+    auto input = makeBuffer(INPUT_BUFFER_SIZE);
+    auto output = makeBuffer(OUTPUT_BUFFER_SIZE);
+
+    size_t lastResult = 0;
+    while (true) {
+        const auto got = readSome(sourceFd, input.get(), INPUT_BUFFER_SIZE);
+        if (got < 0) {
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        ZSTD_inBuffer in{.src = input.get(), .size = size_t(got), .pos = 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out{.dst = output.get(), .size = OUTPUT_BUFFER_SIZE, .pos = 0};
+            lastResult = ZSTD_decompressStream(context.get(), &out, &in);
+            if (ZSTD_isError(lastResult)) {
+                qWarning() << "Failed to decompress zstd core:" << ZSTD_getErrorName(lastResult);
+                return false;
+            }
+            if (!writer.write(output.get(), out.pos)) {
+                return false;
+            }
+        }
+    }
+    if (lastResult != 0) {
+        qWarning() << "zstd core is truncated";
+        return false;
+    }
+    return writer.finish();
+}
+#endif
+
+#if defined(HAVE_LZMA)
+// The index at the end of the stream knows the size. Only single stream files without padding, as systemd writes them,
+// are supported. Anything else could be several streams and we'd only see the size of the last.
+[[nodiscard]] std::optional<quint64> xzUncompressedSize(int sourceFd)
+{
+    struct stat info{};
+    if (fstat(sourceFd, &info) != 0 || info.st_size < off_t(2 * LZMA_STREAM_HEADER_SIZE)) {
+        return std::nullopt;
+    }
+    std::array<uint8_t, LZMA_STREAM_HEADER_SIZE> footer{};
+    if (pread(sourceFd, footer.data(), footer.size(), info.st_size - off_t(footer.size())) != ssize_t(footer.size())) {
+        return std::nullopt;
+    }
+    lzma_stream_flags flags{};
+    if (lzma_stream_footer_decode(&flags, footer.data()) != LZMA_OK || flags.backward_size > quint64(info.st_size) - 2 * LZMA_STREAM_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> indexData(flags.backward_size);
+    const off_t indexOffset = info.st_size - off_t(footer.size()) - off_t(indexData.size());
+    if (pread(sourceFd, indexData.data(), indexData.size(), indexOffset) != ssize_t(indexData.size())) {
+        return std::nullopt;
+    }
+    lzma_index *index = nullptr;
+    uint64_t memoryLimit = UINT64_MAX;
+    size_t position = 0;
+    if (lzma_index_buffer_decode(&index, &memoryLimit, nullptr, indexData.data(), &position, indexData.size()) != LZMA_OK) {
+        return std::nullopt;
+    }
+    const auto freeIndex = qScopeGuard([index] {
+        lzma_index_end(index, nullptr);
+    });
+    if (lzma_index_stream_size(index) != quint64(info.st_size)) {
+        return std::nullopt;
+    }
+    return lzma_index_uncompressed_size(index);
+}
+
+[[nodiscard]] bool decompressXz(int sourceFd, int targetFd)
+{
+    lzma_stream stream = LZMA_STREAM_INIT;
+    SparseWriter writer(targetFd);
+    if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+        return false;
+    }
+    const auto cleanup = qScopeGuard([&stream] {
+        lzma_end(&stream);
+    });
+    auto input = makeBuffer(INPUT_BUFFER_SIZE);
+    auto output = makeBuffer(OUTPUT_BUFFER_SIZE);
+
+    lzma_action action = LZMA_RUN;
+    while (true) {
+        if (stream.avail_in == 0 && action == LZMA_RUN) {
+            const auto got = readSome(sourceFd, input.get(), INPUT_BUFFER_SIZE);
+            if (got < 0) {
+                return false;
+            }
+            stream.next_in = reinterpret_cast<const uint8_t *>(input.get());
+            stream.avail_in = got;
+            if (got == 0) {
+                action = LZMA_FINISH;
+            }
+        }
+        stream.next_out = reinterpret_cast<uint8_t *>(output.get());
+        stream.avail_out = OUTPUT_BUFFER_SIZE;
+        const auto ret = lzma_code(&stream, action);
+        if (!writer.write(output.get(), OUTPUT_BUFFER_SIZE - stream.avail_out)) {
+            return false;
+        }
+        if (ret == LZMA_STREAM_END) {
+            return writer.finish();
+        }
+        if (ret != LZMA_OK) {
+            qWarning() << "Failed to decompress xz core:" << ret;
+            return false;
+        }
+    }
+}
+#endif
+
+#if defined(HAVE_LZ4)
+// Only known when the compressor put it into the frame header.
+[[nodiscard]] std::optional<quint64> lz4UncompressedSize(int sourceFd)
+{
+    LZ4F_dctx *rawContext = nullptr;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&rawContext, LZ4F_VERSION))) {
+        return std::nullopt;
+    }
+    std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> context(rawContext, &LZ4F_freeDecompressionContext);
+    std::array<char, LZ4F_HEADER_SIZE_MAX> header{};
+    const auto got = pread(sourceFd, header.data(), header.size(), 0);
+    if (got <= 0) {
+        return std::nullopt;
+    }
+    LZ4F_frameInfo_t frameInfo{};
+    size_t headerSize = got;
+    if (LZ4F_isError(LZ4F_getFrameInfo(context.get(), &frameInfo, header.data(), &headerSize)) || frameInfo.contentSize == 0) {
+        return std::nullopt;
+    }
+    return frameInfo.contentSize;
+}
+
+[[nodiscard]] bool decompressLz4(int sourceFd, int targetFd)
+{
+    LZ4F_dctx *rawContext = nullptr;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&rawContext, LZ4F_VERSION))) {
+        return false;
+    }
+    std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> context(rawContext, &LZ4F_freeDecompressionContext);
+    SparseWriter writer(targetFd);
+    auto input = makeBuffer(INPUT_BUFFER_SIZE);
+    auto output = makeBuffer(OUTPUT_BUFFER_SIZE);
+
+    size_t lastResult = 0;
+    while (true) {
+        const auto got = readSome(sourceFd, input.get(), INPUT_BUFFER_SIZE);
+        if (got < 0) {
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        size_t offset = 0;
+        while (offset < size_t(got)) {
+            size_t inSize = got - offset;
+            size_t outSize = OUTPUT_BUFFER_SIZE;
+            lastResult = LZ4F_decompress(context.get(), output.get(), &outSize, input.get() + offset, &inSize, nullptr);
+            if (LZ4F_isError(lastResult)) {
+                qWarning() << "Failed to decompress lz4 core:" << LZ4F_getErrorName(lastResult);
+                return false;
+            }
+            offset += inSize;
+            if (!writer.write(output.get(), outSize)) {
+                return false;
+            }
+        }
+    }
+    if (lastResult != 0) {
+        qWarning() << "lz4 core is truncated";
+        return false;
+    }
+    return writer.finish();
+}
+#endif
+} // namespace
+
+NativeExcavator::Result NativeExcavator::excavate(const QString &coreFile, int targetFd)
+{
+    const auto compression = compressionOf(coreFile);
+    if (!isSupported(compression)) {
+        return Result::Unsupported;
+    }
+
+    // The target comes from our caller, possibly across D-Bus. Everything here writes at offsets and leaves holes,
+    // which needs a regular file. Let coredumpctl stream into anything else.
+    if (struct stat info{}; fstat(targetFd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return Result::Unsupported;
+    }
+
+    // O_NONBLOCK so we don't hang on a fifo, it doesn't affect regular files.
+    const int sourceFd = open(QFile::encodeName(coreFile).constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (sourceFd < 0) {
+        qWarning() << "Failed to open core" << coreFile << strerror(errno);
+        return Result::Failed;
+    }
+    const auto closeSource = qScopeGuard([sourceFd] {
+        close(sourceFd);
+    });
+    if (struct stat info{}; fstat(sourceFd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        qWarning() << "Core is not a regular file or empty" << coreFile;
+        return Result::Failed;
+    }
+    if (compression == Compression::None && !isElf(sourceFd)) {
+        qWarning() << "Core is neither compressed nor ELF" << coreFile;
+        return Result::Failed;
+    }
+    posix_fadvise(sourceFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    bool ok = false;
+    switch (compression) {
+    case Compression::None:
+        ok = copyPlain(sourceFd, targetFd);
+        break;
+    case Compression::Zstd:
+#if defined(HAVE_ZSTD)
+        ok = decompressZstd(sourceFd, targetFd);
+#endif
+        break;
+    case Compression::Xz:
+#if defined(HAVE_LZMA)
+        ok = decompressXz(sourceFd, targetFd);
+#endif
+        break;
+    case Compression::Lz4:
+#if defined(HAVE_LZ4)
+        ok = decompressLz4(sourceFd, targetFd);
+#endif
+        break;
+    }
+    return ok ? Result::Excavated : Result::Failed;
+}
+
+std::optional<quint64> NativeExcavator::uncompressedSize(const QString &coreFile)
+{
+    const auto compression = compressionOf(coreFile);
+    if (!isSupported(compression)) {
+        return std::nullopt;
+    }
+
+    const int sourceFd = open(QFile::encodeName(coreFile).constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (sourceFd < 0) {
+        return std::nullopt;
+    }
+    const auto closeSource = qScopeGuard([sourceFd] {
+        close(sourceFd);
+    });
+
+    switch (compression) {
+    case Compression::None:
+        if (struct stat info{}; fstat(sourceFd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && isElf(sourceFd)) {
+            return quint64(info.st_size);
+        }
+        return std::nullopt;
+    case Compression::Zstd:
+#if defined(HAVE_ZSTD)
+        return zstdUncompressedSize(sourceFd);
+#endif
+        break;
+    case Compression::Xz:
+#if defined(HAVE_LZMA)
+        return xzUncompressedSize(sourceFd);
+#endif
+        break;
+    case Compression::Lz4:
+#if defined(HAVE_LZ4)
+        return lz4UncompressedSize(sourceFd);
+#endif
+        break;
+    }
+    return std::nullopt;
+}
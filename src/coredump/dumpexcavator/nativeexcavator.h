@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <optional>
+
+#include <QString>
+
+// Extracts cores stored by systemd-coredump without going through coredumpctl. The stored file gets decompressed
+// straight into the target fd, uncompressed cores get copied in-kernel.
+// This is blocking, run it off the GUI thread.
+namespace NativeExcavator
+{
+enum class Result {
+    Excavated,
+    Unsupported, // not a format we can handle (or were built with) or the target isn't a regular file, use coredumpctl instead
+    Failed, // also when the core is empty or, without compression, not ELF
+};
+
+// Writes the core stored at coreFile to targetFd, starting at the current position of targetFd. targetFd must be a
+// regular file. On failure the target may contain partial data.
+[[nodiscard]] Result excavate(const QString &coreFile, int targetFd);
+
+// Size of the excavated core, as far as it can be told without decompressing. Cheap-ish, only reads headers and indexes.
+[[nodiscard]] std::optional<quint64> uncompressedSize(const QString &coreFile);
+} // namespace NativeExcavator
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "DetailsFormatter.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QLocale>
+
+#include <KUser>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+using Fields = QHash<QByteArray, QByteArray>;
+
+// Same layout as coredumpctl: right aligned labels, continuation lines aligned with the first value.
+constexpr auto LABEL_WIDTH = 14;
+constexpr auto STACK_TRACE_MARKER = "Stack trace of thread"_L1;
+
+void appendLine(QString &output, QLatin1StringView label, const QString &value)
+{
+    if (value.isEmpty()) {
+        return;
+    }
+    const auto indentation = QString(LABEL_WIDTH + 2, u' ');
+    output += QString(label).rightJustified(LABEL_WIDTH) + ": "_L1;
+    const auto lines = QStringView(value).split(u'\n');
+    for (auto it = lines.cbegin(); it != lines.cend(); ++it) {
+        if (it != lines.cbegin()) {
+            output += it->isEmpty() ? QString() : indentation;
+        }
+        output += *it;
+        output += u'\n';
+    }
+}
+
+[[nodiscard]] QString value(const Fields &fields, const QByteArray &key)
+{
+    return QString::fromUtf8(fields.value(key));
+}
+
+[[nodiscard]] QString withUserName(const QString &uid)
+{
+    bool ok = false;
+    const KUser user(K_UID(uid.toUInt(&ok)));
+    if (!ok || !user.isValid()) {
+        return uid;
+    }
+    return u"%1 (%2)"_s.arg(uid, user.loginName());
+}
+
+[[nodiscard]] QString withGroupName(const QString &gid)
+{
+    bool ok = false;
+    const KUserGroup group(K_GID(gid.toUInt(&ok)));
+    if (!ok || !group.isValid()) {
+        return gid;
+    }
+    return u"%1 (%2)"_s.arg(gid, group.name());
+}
+
+[[nodiscard]] QString signalText(const Fields &fields)
+{
+    const auto number = value(fields, "COREDUMP_SIGNAL"_ba);
+    auto name = value(fields, "COREDUMP_SIGNAL_NAME"_ba);
+    if (number.isEmpty() || name.isEmpty()) {
+        return number;
+    }
+    if (name.startsWith("SIG"_L1)) {
+        name.remove(0, 3);
+    }
+    return u"%1 (%2)"_s.arg(number, name);
+}
+
+[[nodiscard]] QString timestamp(const Fields &fields)
+{
+    bool ok = false;
+    const auto usec = fields.value("COREDUMP_TIMESTAMP"_ba).toLongLong(&ok);
+    if (!ok) {
+        return {};
+    }
+    const auto dateTime = QDateTime::fromMSecsSinceEpoch(usec / 1000);
+    return QLocale::c().toString(dateTime, u"ddd yyyy-MM-dd HH:mm:ss t"_s);
+}
+
+[[nodiscard]] QString package(const Fields &fields)
+{
+    const auto name = value(fields, "COREDUMP_PACKAGE_NAME"_ba);
+    const auto version = value(fields, "COREDUMP_PACKAGE_VERSION"_ba);
+    if (name.isEmpty() || version.isEmpty()) {
+        return name;
+    }
+    return name + u'/' + version;
+}
+} // namespace
+
+QString DetailsFormatter::format(const Fields &fields)
+{
+    QString output;
+
+    const auto pid = value(fields, "COREDUMP_PID"_ba);
+    const auto comm = value(fields, "COREDUMP_COMM"_ba);
+    appendLine(output, "PID"_L1, comm.isEmpty() ? pid : u"%1 (%2)"_s.arg(pid, comm));
+    appendLine(output, "UID"_L1, withUserName(value(fields, "COREDUMP_UID"_ba)));
+    appendLine(output, "GID"_L1, withGroupName(value(fields, "COREDUMP_GID"_ba)));
+    appendLine(output, "Signal"_L1, signalText(fields));
+    appendLine(output, "Timestamp"_L1, timestamp(fields));
+    appendLine(output, "Command Line"_L1, value(fields, "COREDUMP_CMDLINE"_ba));
+    appendLine(output, "Executable"_L1, value(fields, "COREDUMP_EXE"_ba));
+    appendLine(output, "Control Group"_L1, value(fields, "COREDUMP_CGROUP"_ba));
+    appendLine(output, "Unit"_L1, value(fields, "COREDUMP_UNIT"_ba));
+    appendLine(output, "User Unit"_L1, value(fields, "COREDUMP_USER_UNIT"_ba));
+    appendLine(output, "Slice"_L1, value(fields, "COREDUMP_SLICE"_ba));
+    appendLine(output, "Owner UID"_L1, withUserName(value(fields, "COREDUMP_OWNER_UID"_ba)));
+    appendLine(output, "Boot ID"_L1, value(fields, "_BOOT_ID"_ba));
+    appendLine(output, "Machine ID"_L1, value(fields, "_MACHINE_ID"_ba));
+    appendLine(output, "Hostname"_L1, value(fields, "_HOSTNAME"_ba));
+
+    const QFileInfo core(value(fields, "COREDUMP_FILENAME"_ba));
+    if (core.filePath().isEmpty()) {
+        appendLine(output, "Storage"_L1, u"none"_s);
+    } else if (core.exists()) {
+        appendLine(output, "Storage"_L1, core.filePath() + " (present)"_L1);
+        appendLine(output, "Size on Disk"_L1, QLocale::c().formattedDataSize(core.size(), 1, QLocale::DataSizeTraditionalFormat));
+    } else {
+        appendLine(output, "Storage"_L1, core.filePath() + " (missing)"_L1);
+    }
+
+    appendLine(output, "Package"_L1, package(fields));
+    appendLine(output, "Message"_L1, value(fields, "MESSAGE"_ba));
+    return output;
+}
+
+bool DetailsFormatter::needsCoredumpctl(const Fields &fields)
+{
+    if (QString::fromUtf8(fields.value("MESSAGE"_ba)).contains(STACK_TRACE_MARKER)) {
+        return false;
+    }
+    // Without a core there is nothing coredumpctl could do better.
+    const auto filename = value(fields, "COREDUMP_FILENAME"_ba);
+    return !filename.isEmpty() && QFileInfo::exists(filename);
+}
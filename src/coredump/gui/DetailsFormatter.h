@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+// Renders the journal fields of a crash the way `coredumpctl info` does, without having to run it.
+// The output isn't localized on purpose, same as coredumpctl's. It ends up in bug reports.
+namespace DetailsFormatter
+{
+[[nodiscard]] QString format(const QHash<QByteArray, QByteArray> &fields);
+// Whether the details lack something only coredumpctl can provide (i.e. it'd produce a stack trace from the core).
+[[nodiscard]] bool needsCoredumpctl(const QHash<QByteArray, QByteArray> &fields);
+} // namespace DetailsFormatter
@@ -3,8 +3,28 @@
 
 #include "DetailsLoader.h"
 
+#include <QCache>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+
 #include <KLocalizedString>
 
+#include "DetailsFormatter.h"
+#include "journalentry.h"
+
+namespace
+{
+using Fields = std::optional<QHash<QByteArray, QByteArray>>;
+
+// Details by journal cursor. Clicking back and forth through the list is common, the details never change.
+QCache<QByteArray, QString> &detailsCache()
+{
+    constexpr auto maxEntries = 64;
+    static QCache<QByteArray, QString> cache(maxEntries);
+    return cache;
+}
+} // namespace
+
 void DetailsLoader::setPatient(Patient *patient)
 {
     if (patient == m_patient) {
@@ -21,17 +41,74 @@ void DetailsLoader::setPatient(Patient *patient)
     Q_EMIT patientChanged();
 }
 
+bool DetailsLoader::isCurrent(const QByteArray &cursor) const
+{
+    return m_patient && m_patient->journalCursor().toUtf8() == cursor;
+}
+
+void DetailsLoader::finish(const QByteArray &cursor, const QString &details)
+{
+    if (!cursor.isEmpty()) {
+        detailsCache().insert(cursor, new QString(details));
+    }
+    if (isCurrent(cursor)) {
+        Q_EMIT this->details(details);
+    }
+}
+
 void DetailsLoader::load()
+{
+    m_LoaderProcess = nullptr;
+    const auto cursor = m_patient->journalCursor().toUtf8();
+
+    // Always deliver asynchronously. The page resets its text when the patient changes, which is after we return.
+    if (const auto cached = detailsCache().object(cursor); cached) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, cursor, details = *cached] {
+                if (isCurrent(cursor)) {
+                    Q_EMIT this->details(details);
+                }
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    if (cursor.isEmpty()) {
+        loadFromCoredumpctl(cursor);
+        return;
+    }
+
+    // Opening the journal can take a moment, keep it off the GUI thread.
+    auto watcher = new QFutureWatcher<Fields>(this);
+    connect(watcher, &QFutureWatcher<Fields>::finished, this, [this, watcher, cursor] {
+        watcher->deleteLater();
+        if (!isCurrent(cursor)) {
+            return; // moved on to another patient meanwhile
+        }
+        const auto fields = watcher->result();
+        if (!fields.has_value() || DetailsFormatter::needsCoredumpctl(fields.value())) {
+            loadFromCoredumpctl(cursor);
+            return;
+        }
+        finish(cursor, DetailsFormatter::format(fields.value()));
+    });
+    watcher->setFuture(QtConcurrent::run([cursor] {
+        return JournalEntry::fields(cursor);
+    }));
+}
+
+void DetailsLoader::loadFromCoredumpctl(const QByteArray &cursor)
 {
     m_LoaderProcess = std::make_unique<QProcess>();
     m_LoaderProcess->setProgram(QStringLiteral("coredumpctl"));
     m_LoaderProcess->setArguments(m_patient->coredumpctlArguments(QStringLiteral("info")));
     m_LoaderProcess->setProcessChannelMode(QProcess::MergedChannels);
-    connect(m_LoaderProcess.get(), &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+    connect(m_LoaderProcess.get(), &QProcess::finished, this, [this, cursor](int exitCode, QProcess::ExitStatus exitStatus) {
         switch (exitStatus) {
         case QProcess::NormalExit:
             if (exitCode == 0) {
-                Q_EMIT details(QString::fromLocal8Bit(m_LoaderProcess->readAll()));
+                finish(cursor, QString::fromLocal8Bit(m_LoaderProcess->readAll()));
             } else {
                 Q_EMIT error(i18nc("@info", "Subprocess exited with error: %1", QString::fromLocal8Bit(m_LoaderProcess->readAll())));
             }
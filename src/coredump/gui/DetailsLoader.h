@@ -30,6 +30,11 @@ Q_SIGNALS:
     void error(const QString &error);
 
 private:
+    // Renders the details from the journal entry, falls back to coredumpctl for what we can't do ourselves.
     void load();
+    void loadFromCoredumpctl(const QByteArray &cursor);
+    // Caches the details and emits them if they still belong to the current patient.
+    void finish(const QByteArray &cursor, const QString &details);
+    [[nodiscard]] bool isCurrent(const QByteArray &cursor) const;
     std::unique_ptr<QProcess> m_LoaderProcess;
 };
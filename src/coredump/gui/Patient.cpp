@@ -7,11 +7,11 @@
 #include <QDebug>
 #include <QDesktopServices>
 #include <QFileInfo>
+#include <QJsonDocument>
 #include <QMessageBox>
 #include <QProcess>
 #include <QUrl>
 
-#include <KApplicationTrader>
 #include <KDirWatch>
 #include <KLocalizedString>
 #include <KOSRelease>
@@ -20,36 +20,58 @@
 
 #include <drkonqipaths.h>
 #include <metadata.h>
+#include <serviceindex.h>
 
 #include "../coredump/coredump.h"
+#include "StringPool.h"
 
 using namespace Qt::StringLiterals;
 
+namespace
+{
+constexpr auto REPORTED_KEY = "Reported"_L1;
+
+// os-release doesn't change while we run, parsing it once is plenty. Read-only and therefore thread-safe.
+const KOSRelease &osRelease()
+{
+    static const KOSRelease release;
+    return release;
+}
+} // namespace
+
 std::optional<FaultContext> loadKDEFaultContext(const QString &metadataPath)
 {
     const auto metadata = Metadata::readFromDisk(metadataPath);
     if (metadata.isEmpty() || metadata.value(u"kcrash"_s).toObject().isEmpty()) {
         return std::nullopt;
     }
+    const auto drkonqi = metadata.value(Metadata::DRKONQI_KEY).toObject();
     return FaultContext{
         .entity = FaultContext::Entity::KDE,
         .name = {}, // unused
         .drkonqiMetadataPath = metadataPath,
-        .drkonqiMetadata = metadata,
-        .reportedToKDE = !metadata.value(Metadata::DRKONQI_KEY).toObject().value(Metadata::SENTRY_EVENT_ID_KEY).toString().isEmpty(),
+        .sentryEventId = drkonqi.value(Metadata::SENTRY_EVENT_ID_KEY).toString(),
+        .reported = drkonqi.value(REPORTED_KEY).toBool(),
     };
 }
 
-Patient::Patient(const Coredump &dump)
-    : m_origCoreFilename(QString::fromUtf8(dump.m_rawData.value("COREDUMP_FILENAME")))
+Patient::Patient(PatientData data)
+    : m_origCoreFilename(std::move(data.origCoreFilename))
     , m_coreFileInfo(m_origCoreFilename)
-    , m_signal(dump.m_rawData["COREDUMP_SIGNAL"].toInt())
-    , m_appName(QFileInfo(dump.exe).fileName())
-    , m_pid(dump.pid)
-    , m_timestamp(dump.m_rawData["COREDUMP_TIMESTAMP"].toLong())
-    , m_coredumpExe(dump.m_rawData["COREDUMP_EXE"])
-    , m_coredumpCom(dump.m_rawData["COREDUMP_COMM"])
-    , m_faultContext([this, &dump]() -> FaultContext {
+    , m_signal(data.signal)
+    , m_appName(std::move(data.appName))
+    , m_pid(data.pid)
+    , m_timestamp(data.timestamp)
+    , m_coredumpExe(std::move(data.coredumpExe))
+    , m_coredumpCom(std::move(data.coredumpCom))
+    , m_faultContext(std::move(data.faultContext))
+    , m_journalCursor(std::move(data.journalCursor))
+{
+}
+
+PatientData Patient::dataFromDump(const Coredump &dump)
+{
+    const auto faultContext = [&dump]() -> FaultContext {
         const QString userUnit = QString::fromUtf8(dump.m_rawData.value("COREDUMP_USER_UNIT"_ba));
         const QString systemUnit = QString::fromUtf8(dump.m_rawData.value("COREDUMP_UNIT"_ba));
 
@@ -63,7 +85,7 @@ Patient::Patient(const Coredump &dump)
                 const auto end = unit.mid(flatpakPrefix.size());
                 return end.left(end.indexOf('-'_L1));
             }();
-            return {.entity = FaultContext::Entity::Flatpak, .name = flatpakName};
+            return {.entity = FaultContext::Entity::Flatpak, .name = StringPool::intern(flatpakName)};
         }
 
         for (const auto &unit : {userUnit, systemUnit}) {
@@ -76,17 +98,76 @@ Patient::Patient(const Coredump &dump)
                 const auto end = unit.mid(snapPrefix.size());
                 return end.left(end.indexOf('.'_L1));
             }();
-            return {.entity = FaultContext::Entity::Snap, .name = snapName};
+            return {.entity = FaultContext::Entity::Snap, .name = StringPool::intern(snapName)};
         }
 
         if (auto context = loadKDEFaultContext(Metadata::drkonqiMetadataPath(dump.exe, dump.bootId, dump.timestamp, dump.pid))) {
             return *context;
         }
 
-        return {.entity = FaultContext::Entity::Distro, .name = m_osRelease.prettyName()};
-    }())
-    , m_journalCursor(QString::fromUtf8(dump.m_cursor))
+        return {.entity = FaultContext::Entity::Distro, .name = osRelease().prettyName()};
+    }();
+
+    return {
+        .origCoreFilename = QString::fromUtf8(dump.m_rawData.value("COREDUMP_FILENAME")),
+        .signal = dump.m_rawData.value("COREDUMP_SIGNAL").toInt(),
+        .appName = StringPool::intern(QFileInfo(dump.exe).fileName()),
+        .pid = dump.pid,
+        .timestamp = dump.m_rawData.value("COREDUMP_TIMESTAMP").toLong(),
+        .coredumpExe = StringPool::intern(dump.m_rawData.value("COREDUMP_EXE")),
+        .coredumpCom = StringPool::intern(dump.m_rawData.value("COREDUMP_COMM")),
+        .faultContext = faultContext,
+        .journalCursor = QString::fromUtf8(dump.m_cursor),
+    };
+}
+
+QList<QByteArray> Patient::journalFields()
+{
+    return {
+        // Coredump
+        "COREDUMP_UID"_ba,
+        "COREDUMP_PID"_ba,
+        "COREDUMP_EXE"_ba,
+        Coredump::keyFilename(),
+        "_SYSTEMD_UNIT"_ba,
+        "_BOOT_ID"_ba,
+        "COREDUMP_TIMESTAMP"_ba,
+        // Patient
+        "COREDUMP_SIGNAL"_ba,
+        "COREDUMP_COMM"_ba,
+        "COREDUMP_USER_UNIT"_ba,
+        "COREDUMP_UNIT"_ba,
+    };
+}
+
+QString Patient::journalCursor() const
+{
+    return m_journalCursor;
+}
+
+QString Patient::appName() const
+{
+    return m_appName;
+}
+
+QByteArray Patient::coredumpExe() const
 {
+    return m_coredumpExe;
+}
+
+int Patient::signal() const
+{
+    return m_signal;
+}
+
+time_t Patient::timestamp() const
+{
+    return m_timestamp;
+}
+
+const FaultContext &Patient::faultContext() const
+{
+    return m_faultContext;
 }
 
 QStringList Patient::coredumpctlArguments(const QString &command) const
@@ -133,7 +214,7 @@ void Patient::debug()
             m_coreFileInfo = QFileInfo(corePath);
             launchDebugger();
         });
-        m_excavator->excavateFrom(m_coreFileInfo.filePath());
+        m_excavator->excavateFrom(m_coreFileInfo.filePath(), m_journalCursor.toUtf8());
         return;
     }
     if (m_coreFileInfo.isReadable()) {
@@ -151,24 +232,10 @@ QString Patient::dateTime() const
 
 QString Patient::iconName() const
 {
-    // Caching it because it's an N² look-up and there generally are tons of duplicates
-    static QHash<QString, QString> s_cache;
-    const QString executable = m_appName;
-    auto it = s_cache.find(executable);
-    if (it == s_cache.end()) {
-        const auto servicesFound = KApplicationTrader::query([&executable](const KService::Ptr &service) {
-            return QFileInfo(service->exec()).fileName() == executable;
-        });
-
-        QString iconName;
-        if (servicesFound.isEmpty()) {
-            iconName = QStringLiteral("applications-science");
-        } else {
-            iconName = servicesFound.constFirst()->icon();
-        }
-        it = s_cache.insert(executable, iconName);
+    if (const auto service = ServiceIndex::self()->serviceForExecutable(m_appName); service) {
+        return service->icon();
     }
-    return *it;
+    return QStringLiteral("applications-science");
 }
 
 bool Patient::canDebug() const
@@ -209,10 +276,10 @@ bool Patient::canReport()
     case FaultContext::Entity::Snap:
         return true;
     case FaultContext::Entity::Distro:
-        return !m_osRelease.bugReportUrl().isEmpty();
+        return !osRelease().bugReportUrl().isEmpty();
     case FaultContext::Entity::KDE:
         // We only accept symbolicated reports so canDebug is a pre-condition here.
-        return canDebug() && !m_faultContext.reportedToKDE;
+        return canDebug() && !m_faultContext.reportedToKDE();
     }
     Q_ASSERT_X(false, Q_FUNC_INFO, "Unhandled enum value");
     return false;
@@ -231,7 +298,7 @@ QString Patient::reasonForNoReport() const
     case FaultContext::Entity::Snap:
         return {}; // enabled -> simply direct to snap store
     case FaultContext::Entity::Distro:
-        if (m_osRelease.bugReportUrl().isEmpty()) {
+        if (osRelease().bugReportUrl().isEmpty()) {
             return i18nc("@info", "Your distribution has not provided a bug report URL. Please report this to your distribution.");
         }
         return {}; // enabled
@@ -253,7 +320,8 @@ void Patient::report()
     case FaultContext::Entity::KDE: {
         auto job = new KIO::CommandLauncherJob(
             Paths::drkonqiExe(),
-            QStringList{u"--dialog"_s} + Metadata::metadataArguments(m_faultContext.drkonqiMetadata[Metadata::KCRASH_KEY].toObject().toVariantHash()),
+            QStringList{u"--dialog"_s}
+                + Metadata::metadataArguments(Metadata::readFromDisk(m_faultContext.drkonqiMetadataPath)[Metadata::KCRASH_KEY].toObject().toVariantHash()),
             this);
         auto env = QProcessEnvironment::systemEnvironment();
         env.insert(u"DRKONQI_BACKEND"_s, u"COREDUMPD"_s);
@@ -263,7 +331,9 @@ void Patient::report()
         auto dirWatch = new KDirWatch(this);
         dirWatch->addFile(m_faultContext.drkonqiMetadataPath);
         connect(dirWatch, &KDirWatch::dirty, this, [this] {
-            m_faultContext = *loadKDEFaultContext(m_faultContext.drkonqiMetadataPath);
+            if (auto context = loadKDEFaultContext(m_faultContext.drkonqiMetadataPath)) {
+                m_faultContext = *context;
+            }
             Q_EMIT changed();
         });
         // TODO: this is a bit awkward because it allows the user to open the same report multiple times. There is no
@@ -271,7 +341,7 @@ void Patient::report()
         return;
     }
     case FaultContext::Entity::Distro:
-        QDesktopServices::openUrl(QUrl(m_osRelease.bugReportUrl()));
+        QDesktopServices::openUrl(QUrl(osRelease().bugReportUrl()));
         markAsReported();
         return;
     }
@@ -288,7 +358,7 @@ void Patient::report()
     case FaultContext::Entity::KDE:
         return i18nc("@info the name of where to report bugs", "KDE");
     case FaultContext::Entity::Distro:
-        return m_osRelease.prettyName();
+        return osRelease().prettyName();
     }
     Q_ASSERT_X(false, Q_FUNC_INFO, "Unhandled enum value");
     return {};
@@ -296,21 +366,24 @@ void Patient::report()
 
 bool Patient::reported() const
 {
-    return m_faultContext.drkonqiMetadata[Metadata::DRKONQI_KEY].toObject()[u"Reported"_s].toBool() || m_faultContext.reportedToKDE;
+    return m_faultContext.reported || m_faultContext.reportedToKDE();
 }
 
 void Patient::markAsReported()
 {
-    auto drKonqi = m_faultContext.drkonqiMetadata[Metadata::DRKONQI_KEY].toObject();
-    drKonqi[u"Reported"_s] = true;
-    m_faultContext.drkonqiMetadata[Metadata::DRKONQI_KEY] = drKonqi;
+    m_faultContext.reported = true;
     Q_EMIT changed();
+
+    auto metadata = Metadata::readFromDisk(m_faultContext.drkonqiMetadataPath);
+    auto drKonqi = metadata[Metadata::DRKONQI_KEY].toObject();
+    drKonqi[REPORTED_KEY] = true;
+    metadata[Metadata::DRKONQI_KEY] = drKonqi;
     QFile file(m_faultContext.drkonqiMetadataPath);
     if (!file.open(QFile::WriteOnly)) {
         qWarning() << "Could not open" << m_faultContext.drkonqiMetadataPath << "to mark report as sent.";
         return;
     }
-    file.write(QJsonDocument(m_faultContext.drkonqiMetadata).toJson());
+    file.write(QJsonDocument(metadata).toJson());
     file.close();
 }
 
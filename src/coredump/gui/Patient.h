@@ -3,12 +3,11 @@
 
 #pragma once
 
+#include <optional>
+
 #include <QFileInfo>
-#include <QJsonObject>
 #include <QObject>
 
-#include <KOSRelease>
-
 #include <automaticcoredumpexcavator.h>
 #include <qqmlintegration.h>
 
@@ -24,8 +23,30 @@ struct FaultContext {
     Entity entity;
     QString name;
     QString drkonqiMetadataPath = {}; // NOLINT this is not a redundant init!
-    QJsonObject drkonqiMetadata = {}; // NOLINT this is not a redundant init!
-    bool reportedToKDE = false;
+    // Condensed from the metadata. The metadata itself is only read from disk when reporting needs it.
+    QString sentryEventId = {}; // NOLINT this is not a redundant init!
+    bool reported = false;
+
+    [[nodiscard]] bool reportedToKDE() const
+    {
+        return !sentryEventId.isEmpty();
+    }
+};
+
+// nullopt when the metadata doesn't describe a KDE crash (i.e. has no kcrash data)
+[[nodiscard]] std::optional<FaultContext> loadKDEFaultContext(const QString &metadataPath);
+
+// Everything a Patient is made of. Plain values so it can be put together off the GUI thread (see PatientLoader).
+struct PatientData {
+    QString origCoreFilename;
+    int signal = -1;
+    QString appName;
+    pid_t pid = 0;
+    time_t timestamp = 0;
+    QByteArray coredumpExe;
+    QByteArray coredumpCom;
+    FaultContext faultContext;
+    QString journalCursor;
 };
 
 class Patient : public QObject
@@ -56,7 +77,11 @@ class Patient : public QObject
     Q_PROPERTY(QString journalCursor MEMBER m_journalCursor CONSTANT)
     Q_PROPERTY(bool reported READ reported NOTIFY changed)
 public:
-    explicit Patient(const Coredump &dump);
+    explicit Patient(PatientData data);
+    // Thread-safe. Does all the (blocking) IO a Patient needs, such as loading the KDE metadata.
+    [[nodiscard]] static PatientData dataFromDump(const Coredump &dump);
+    // The journal fields dataFromDump needs. Everything else isn't read from the journal.
+    [[nodiscard]] static QList<QByteArray> journalFields();
 
     QStringList coredumpctlArguments(const QString &command) const;
 
@@ -70,6 +95,12 @@ public:
     Q_INVOKABLE [[nodiscard]] QString reasonForNoReport() const;
     Q_INVOKABLE void report();
     [[nodiscard]] bool reported() const;
+    [[nodiscard]] QString journalCursor() const;
+    [[nodiscard]] QString appName() const;
+    [[nodiscard]] QByteArray coredumpExe() const;
+    [[nodiscard]] int signal() const;
+    [[nodiscard]] time_t timestamp() const;
+    [[nodiscard]] const FaultContext &faultContext() const;
 
 Q_SIGNALS:
     void changed();
@@ -82,11 +113,7 @@ private:
 
     const QByteArray m_coredumpExe;
     const QByteArray m_coredumpCom;
-    QString m_iconName;
     std::unique_ptr<AutomaticCoredumpExcavator> m_excavator;
-    QByteArray m_systemUnit;
-    QByteArray m_userUnit;
-    KOSRelease m_osRelease;
     FaultContext m_faultContext;
     QString m_journalCursor;
 };
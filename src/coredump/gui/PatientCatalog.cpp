@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "PatientCatalog.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "StringPool.h"
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr quint32 MAGIC = 0x444b5043; // DKPC
+// Bump whenever PatientData or the way it is derived changes. Old catalogs are thrown away and rebuilt.
+constexpr quint32 VERSION = 2;
+// Lower bound of what write() produces for a single patient, that is with all strings empty.
+constexpr qint64 MIN_RECORD_SIZE = 32;
+
+[[nodiscard]] qint64 modificationTime(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+void write(QDataStream &stream, const PatientData &data)
+{
+    const auto &context = data.faultContext;
+    stream << data.origCoreFilename << qint32(data.signal) << data.appName << qint64(data.pid) << qint64(data.timestamp) << data.coredumpExe
+           << data.coredumpCom << data.journalCursor;
+    stream << qint32(context.entity) << context.name << context.drkonqiMetadataPath << context.sentryEventId << context.reported;
+    if (context.entity == FaultContext::Entity::KDE) {
+        stream << modificationTime(context.drkonqiMetadataPath);
+    }
+}
+
+[[nodiscard]] PatientData read(QDataStream &stream)
+{
+    PatientData data;
+    auto &context = data.faultContext;
+    qint32 signal = 0;
+    qint64 pid = 0;
+    qint64 timestamp = 0;
+    qint32 entity = 0;
+    stream >> data.origCoreFilename >> signal >> data.appName >> pid >> timestamp >> data.coredumpExe >> data.coredumpCom >> data.journalCursor;
+    stream >> entity >> context.name >> context.drkonqiMetadataPath >> context.sentryEventId >> context.reported;
+    data.signal = signal;
+    data.pid = pid_t(pid);
+    data.timestamp = time_t(timestamp);
+    // Crash histories are mostly the same few applications over and over.
+    data.appName = StringPool::intern(data.appName);
+    data.coredumpExe = StringPool::intern(data.coredumpExe);
+    data.coredumpCom = StringPool::intern(data.coredumpCom);
+    context.name = StringPool::intern(context.name);
+    context.entity = FaultContext::Entity(entity);
+    if (context.entity == FaultContext::Entity::KDE) {
+        qint64 modified = 0;
+        stream >> modified;
+        if (modified != modificationTime(context.drkonqiMetadataPath)) {
+            // Changed since (e.g. reported) or gone.
+            if (auto reloaded = loadKDEFaultContext(context.drkonqiMetadataPath)) {
+                context = *reloaded;
+            }
+        }
+    }
+    return data;
+}
+} // namespace
+
+QString PatientCatalog::path()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + u"/patients.catalog"_s;
+}
+
+std::optional<PatientCatalog::Catalog> PatientCatalog::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != MAGIC || version != VERSION) {
+        qDebug() << "Ignoring incompatible catalog" << path << version;
+        return std::nullopt;
+    }
+
+    Catalog catalog;
+    quint32 count = 0;
+    stream >> catalog.cursor >> count;
+    // The count may be garbage, don't let it allocate more than the file could possibly hold.
+    catalog.patients.reserve(std::min<qint64>(count, file.bytesAvailable() / MIN_RECORD_SIZE));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        catalog.patients.append(read(stream));
+    }
+    if (stream.status() != QDataStream::Ok || catalog.cursor.isEmpty()) {
+        qWarning() << "Ignoring corrupt catalog" << path;
+        return std::nullopt;
+    }
+    return catalog;
+}
+
+bool PatientCatalog::save(const QString &path, const Catalog &catalog)
+{
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "Failed to open catalog for writing" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << MAGIC << VERSION << catalog.cursor << quint32(catalog.patients.size());
+    for (const auto &patient : catalog.patients) {
+        write(stream, patient);
+    }
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write catalog" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <optional>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "Patient.h"
+
+// On-disk cache of everything we derived from the journal, so startup doesn't have to rescan years of crashes.
+// Holds the cursor of the last entry seen, the journal only needs reading from there on.
+// Thread-safe, used by the PatientLoader.
+namespace PatientCatalog
+{
+struct Catalog {
+    QByteArray cursor;
+    QList<PatientData> patients;
+};
+
+[[nodiscard]] QString path();
+// nullopt when there is no catalog or it is unusable (e.g. written by an incompatible version).
+// KDE metadata that changed since the catalog was written (e.g. because the crash got reported) is reloaded.
+[[nodiscard]] std::optional<Catalog> load(const QString &path);
+bool save(const QString &path, const Catalog &catalog);
+} // namespace PatientCatalog
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "PatientFilterModel.h"
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "Patient.h"
+#include "PatientModel.h"
+
+using namespace Qt::StringLiterals;
+
+PatientFilterModel::PatientFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    connect(this, &QAbstractItemModel::rowsInserted, this, &PatientFilterModel::countChanged);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &PatientFilterModel::countChanged);
+    connect(this, &QAbstractItemModel::modelReset, this, &PatientFilterModel::countChanged);
+    connect(this, &QAbstractItemModel::layoutChanged, this, &PatientFilterModel::countChanged);
+    connect(this, &PatientFilterModel::countChanged, this, &PatientFilterModel::scheduleCount);
+
+    // Crashes tend to arrive in bulk, count once they are all in.
+    m_countTimer.setSingleShot(true);
+    m_countTimer.setInterval(0);
+    connect(&m_countTimer, &QTimer::timeout, this, &PatientFilterModel::countApplications);
+
+    // The actual order is defined by lessThan.
+    sort(0, Qt::AscendingOrder);
+}
+
+void PatientFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    for (const auto &connection : std::as_const(m_sourceConnections)) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+
+    // Connected before the base class connects itself, so the keys are up to date by the time it filters and sorts.
+    if (sourceModel) {
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsInserted, this, [this, sourceModel](const QModelIndex &, int first, int last) {
+            std::vector<Key> keys;
+            keys.reserve(last - first + 1);
+            for (int row = first; row <= last; ++row) {
+                keys.push_back(makeKey(sourceModel, row));
+            }
+            m_keys.insert(m_keys.begin() + first, std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()));
+        });
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+            m_keys.erase(m_keys.begin() + first, m_keys.begin() + last + 1);
+        });
+        m_sourceConnections << connect(sourceModel,
+                                       &QAbstractItemModel::dataChanged,
+                                       this,
+                                       [this, sourceModel](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                                           for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                                               m_keys.at(row) = makeKey(sourceModel, row);
+                                           }
+                                           scheduleCount();
+                                       });
+        const auto rebuild = [this, sourceModel] {
+            rebuildKeys(sourceModel);
+        };
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::modelReset, this, rebuild);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::layoutChanged, this, rebuild);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsMoved, this, rebuild);
+    }
+    rebuildKeys(sourceModel);
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+QString PatientFilterModel::filterString() const
+{
+    return m_filterString;
+}
+
+void PatientFilterModel::setFilterString(const QString &filterString)
+{
+    if (m_filterString == filterString) {
+        return;
+    }
+
+    const auto needle = filterString.toLower();
+    // Typing on can only ever narrow the search, only what matched before needs looking at.
+    const bool narrowing = needle.contains(m_needle);
+    m_filterString = filterString;
+    m_needle = needle;
+    for (auto &key : m_keys) {
+        if (narrowing && !key.matches) {
+            continue;
+        }
+        key.matches = key.haystack.contains(m_needle);
+    }
+
+    invalidateRowsFilter();
+    scheduleCount();
+    Q_EMIT filterStringChanged();
+}
+
+bool PatientFilterModel::showReported() const
+{
+    return m_showReported;
+}
+
+void PatientFilterModel::setShowReported(bool show)
+{
+    if (m_showReported == show) {
+        return;
+    }
+    m_showReported = show;
+    invalidateRowsFilter();
+    scheduleCount();
+    Q_EMIT showReportedChanged();
+}
+
+bool PatientFilterModel::groupByApplication() const
+{
+    return m_groupByApplication;
+}
+
+void PatientFilterModel::setGroupByApplication(bool group)
+{
+    if (m_groupByApplication == group) {
+        return;
+    }
+    m_groupByApplication = group;
+    invalidate();
+    Q_EMIT groupByApplicationChanged();
+}
+
+QVariantMap PatientFilterModel::applicationCounts() const
+{
+    return m_applicationCounts;
+}
+
+bool PatientFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent); // flat list
+    if (sourceRow < 0 || std::cmp_greater_equal(sourceRow, m_keys.size())) {
+        return false;
+    }
+    return accepted(m_keys.at(sourceRow));
+}
+
+bool PatientFilterModel::lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const
+{
+    const auto &left = m_keys.at(sourceLeft.row());
+    const auto &right = m_keys.at(sourceRight.row());
+    if (m_groupByApplication) {
+        if (const auto order = QString::compare(left.application, right.application, Qt::CaseInsensitive); order != 0) {
+            return order < 0;
+        }
+    }
+    // Newest first. Crashes from the same microsecond (hardly) stay in journal order.
+    if (left.timestamp != right.timestamp) {
+        return left.timestamp > right.timestamp;
+    }
+    return sourceLeft.row() > sourceRight.row();
+}
+
+PatientFilterModel::Key PatientFilterModel::makeKey(const QAbstractItemModel *model, int sourceRow) const
+{
+    const auto patient = model->data(model->index(sourceRow, 0), PatientModel::ObjectRole).value<Patient *>();
+    if (!patient) {
+        return {};
+    }
+
+    QStringList terms{patient->appName(), QString::fromUtf8(patient->coredumpExe()), patient->faultEntityName()};
+    if (const auto signalName = sigabbrev_np(patient->signal()); signalName) {
+        terms << "SIG"_L1 + QLatin1StringView(signalName);
+    }
+    if (const auto &eventId = patient->faultContext().sentryEventId; !eventId.isEmpty()) {
+        terms << eventId;
+    }
+
+    Key key{
+        .application = patient->appName(),
+        .haystack = terms.join(u'\n').toLower(),
+        .timestamp = patient->timestamp(),
+        .reported = patient->reported(),
+    };
+    key.matches = key.haystack.contains(m_needle);
+    return key;
+}
+
+bool PatientFilterModel::accepted(const Key &key) const
+{
+    return key.matches && (m_showReported || !key.reported);
+}
+
+void PatientFilterModel::rebuildKeys(const QAbstractItemModel *model)
+{
+    m_keys.clear();
+    if (!model) {
+        return;
+    }
+    const int rows = model->rowCount();
+    m_keys.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        m_keys.push_back(makeKey(model, row));
+    }
+}
+
+void PatientFilterModel::scheduleCount()
+{
+    if (!m_countTimer.isActive()) {
+        m_countTimer.start();
+    }
+}
+
+void PatientFilterModel::countApplications()
+{
+    QHash<QString, int> counts;
+    for (const auto &key : m_keys) {
+        if (accepted(key)) {
+            ++counts[key.application];
+        }
+    }
+
+    QVariantMap applicationCounts;
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        applicationCounts.insert(it.key(), it.value());
+    }
+    if (applicationCounts != m_applicationCounts) {
+        m_applicationCounts = applicationCounts;
+        Q_EMIT applicationCountsChanged();
+    }
+}
+
+#include "moc_PatientFilterModel.cpp"
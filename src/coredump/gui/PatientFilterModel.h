@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <vector>
+
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QVariantMap>
+#include <qqmlintegration.h>
+
+// Search, filter and sort for the PatientModel. Everything filtering and sorting needs is extracted from the patients
+// once, when they get added, so neither has to go through the meta object system for every row.
+// Sorted newest first, optionally grouped by application.
+class PatientFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    // Matched case-insensitively against application, executable, signal, fault entity and Sentry event id.
+    Q_PROPERTY(QString filterString READ filterString WRITE setFilterString NOTIFY filterStringChanged)
+    Q_PROPERTY(bool showReported READ showReported WRITE setShowReported NOTIFY showReportedChanged)
+    Q_PROPERTY(bool groupByApplication READ groupByApplication WRITE setGroupByApplication NOTIFY groupByApplicationChanged)
+    // Application name -> number of crashes passing the filter
+    Q_PROPERTY(QVariantMap applicationCounts READ applicationCounts NOTIFY applicationCountsChanged)
+
+public:
+    explicit PatientFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    [[nodiscard]] QString filterString() const;
+    void setFilterString(const QString &filterString);
+    Q_SIGNAL void filterStringChanged();
+
+    [[nodiscard]] bool showReported() const;
+    void setShowReported(bool show);
+    Q_SIGNAL void showReportedChanged();
+
+    [[nodiscard]] bool groupByApplication() const;
+    void setGroupByApplication(bool group);
+    Q_SIGNAL void groupByApplicationChanged();
+
+    [[nodiscard]] QVariantMap applicationCounts() const;
+    Q_SIGNAL void applicationCountsChanged();
+
+    Q_SIGNAL void countChanged();
+
+protected:
+    [[nodiscard]] bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    [[nodiscard]] bool lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const override;
+
+private:
+    struct Key {
+        QString application;
+        // Lower case, newline separated search terms
+        QString haystack;
+        time_t timestamp = 0;
+        bool reported = false;
+        bool matches = true;
+    };
+
+    [[nodiscard]] Key makeKey(const QAbstractItemModel *model, int sourceRow) const;
+    [[nodiscard]] bool accepted(const Key &key) const;
+    void rebuildKeys(const QAbstractItemModel *model);
+    void scheduleCount();
+    void countApplications();
+
+    std::vector<Key> m_keys; // by source row
+    QString m_filterString;
+    QString m_needle;
+    bool m_showReported = true;
+    bool m_groupByApplication = false;
+    QVariantMap m_applicationCounts;
+    QTimer m_countTimer;
+    QList<QMetaObject::Connection> m_sourceConnections;
+};
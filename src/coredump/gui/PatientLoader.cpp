@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "PatientLoader.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include "coredumpwatcher.h"
+
+void PatientLoader::start()
+{
+    Q_ASSERT(!m_watcher);
+
+    // Opened in the worker thread and only ever used there. Journal contexts are not thread-safe.
+    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open, SD_JOURNAL_LOCAL_ONLY);
+    if (expectedJournal.ret != 0 || !expectedJournal.value) {
+        qWarning() << "Failed to open journal" << expectedJournal.ret;
+        Q_EMIT atLogEnd();
+        return;
+    }
+    auto journal = std::move(expectedJournal.value);
+
+    if (auto catalog = PatientCatalog::load(PatientCatalog::path())) {
+        m_catalog = std::move(catalog.value());
+        // Entries older than the journal's oldest entry have been vacuumed, the crashes are gone for good.
+        uint64_t cutoff = 0;
+        if (sd_journal_get_cutoff_realtime_usec(journal.get(), &cutoff, nullptr) == 0) {
+            const auto removed = m_catalog.patients.removeIf([cutoff](const PatientData &patient) {
+                return patient.timestamp < time_t(cutoff);
+            });
+            m_catalogDirty = removed > 0;
+        }
+        qDebug() << "Loaded" << m_catalog.patients.size() << "patients from catalog";
+        Q_EMIT loaded(m_catalog.patients);
+    }
+
+    m_watcher = new CoredumpWatcher(std::move(journal), {}, {}, this);
+    if (!m_catalog.cursor.isEmpty()) {
+        m_watcher->setCursor(m_catalog.cursor);
+    }
+    // Only read what we display. In particular never touch COREDUMP_PROC_MAPS and friends or cores stored in the journal.
+    m_watcher->setFields(Patient::journalFields());
+    constexpr size_t fieldThreshold = 4096; // plenty for paths and unit names
+    m_watcher->setDataThreshold(fieldThreshold);
+    connect(m_watcher, &CoredumpWatcher::newDump, this, [this](const auto &dump) {
+        m_pending.append(Patient::dataFromDump(dump));
+        // The watcher yields to the event loop between batches of entries. Flush then, so every batch makes one chunk.
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(this, &PatientLoader::flush, Qt::QueuedConnection);
+        }
+    });
+    connect(m_watcher, &CoredumpWatcher::atLogEnd, this, [this] {
+        flush();
+        saveCatalog();
+        Q_EMIT atLogEnd();
+    });
+    connect(m_watcher, &CoredumpWatcher::error, this, [this](const QString &message) {
+        qWarning() << "Failed to read journal:" << message;
+        // Most likely the catalog's cursor is no good. Next time start from scratch.
+        QFile::remove(PatientCatalog::path());
+        Q_EMIT atLogEnd();
+    });
+    m_watcher->start();
+}
+
+void PatientLoader::flush()
+{
+    m_flushScheduled = false;
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    Q_EMIT loaded(m_pending);
+    m_catalog.cursor = m_pending.constLast().journalCursor.toUtf8();
+    m_catalog.patients.append(m_pending);
+    m_catalogDirty = true;
+    m_pending.clear();
+}
+
+void PatientLoader::saveCatalog()
+{
+    if (!m_catalogDirty || m_catalog.cursor.isEmpty()) {
+        return;
+    }
+    if (PatientCatalog::save(PatientCatalog::path(), m_catalog)) {
+        m_catalogDirty = false;
+    }
+}
+
+#include "moc_PatientLoader.cpp"
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+
+#include "Patient.h"
+#include "PatientCatalog.h"
+
+class CoredumpWatcher;
+
+// Scans the journal and loads the patients' data. Lives in a worker thread of its own, with years of crashes in
+// the journal this takes a good while. Results are handed out in chunks, so the model can insert a whole chunk at once.
+// What was loaded gets recorded in the PatientCatalog. The next start hands out the catalog right away and only reads
+// the journal entries that came after it.
+class PatientLoader : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+
+    // Call through a queued invocation once moved to the worker thread.
+    void start();
+
+Q_SIGNALS:
+    void loaded(const QList<PatientData> &patients);
+    // All past crashes have been loaded. New crashes continue to arrive through loaded.
+    void atLogEnd();
+
+private:
+    void flush();
+    void saveCatalog();
+
+    CoredumpWatcher *m_watcher = nullptr;
+    QList<PatientData> m_pending;
+    PatientCatalog::Catalog m_catalog;
+    bool m_catalogDirty = false;
+    bool m_flushScheduled = false;
+};
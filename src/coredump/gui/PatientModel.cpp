@@ -3,32 +3,60 @@
 
 #include "PatientModel.h"
 
+#include <algorithm>
 #include <chrono>
+#include <utility>
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QMetaMethod>
 
 #include "Patient.h"
-#include "coredumpwatcher.h"
+#include "PatientLoader.h"
 
 using namespace std::chrono_literals;
+using namespace Qt::StringLiterals;
 
 PatientModel::PatientModel(QObject *parent)
     : QAbstractListModel(parent)
 {
     initRoleNames(Patient::staticMetaObject);
+    m_propertyChangedSlot = propertyChangedMetaMethod();
 
-    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open, SD_JOURNAL_LOCAL_ONLY);
-    Q_ASSERT(expectedJournal.ret == 0);
-    Q_ASSERT(expectedJournal.value);
-    auto watcher = new CoredumpWatcher(std::move(expectedJournal.value), {}, {}, this);
-    connect(watcher, &CoredumpWatcher::newDump, this, [&](const auto &dump) {
-        addObject(std::make_unique<Patient>(dump));
-    });
-    connect(watcher, &CoredumpWatcher::atLogEnd, this, [&]() {
+    // Changes tend to come in bursts (e.g. when the KDE metadata of many crashes gets loaded), coalesce them.
+    m_changeTimer.setSingleShot(true);
+    m_changeTimer.setInterval(0);
+    connect(&m_changeTimer, &QTimer::timeout, this, &PatientModel::flushChanges);
+}
+
+void PatientModel::load()
+{
+    if (std::exchange(m_loading, true)) {
+        return;
+    }
+
+    // Journal scanning and data loading happen in the worker, we only get to construct the objects.
+    auto loader = new PatientLoader;
+    loader->moveToThread(&m_loaderThread);
+    connect(&m_loaderThread, &QThread::finished, loader, &QObject::deleteLater);
+    connect(loader, &PatientLoader::loaded, this, &PatientModel::addPatients);
+    connect(loader, &PatientLoader::atLogEnd, this, [this] {
         setReady(true);
     });
-    QMetaObject::invokeMethod(watcher, &CoredumpWatcher::start, Qt::QueuedConnection);
+    // We are a function static and outlive the application, stop the thread while there still is one.
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this] {
+        m_loaderThread.quit();
+        m_loaderThread.wait();
+    });
+    m_loaderThread.setObjectName(u"PatientLoader"_s);
+    m_loaderThread.start(QThread::LowPriority);
+    QMetaObject::invokeMethod(loader, &PatientLoader::start, Qt::QueuedConnection);
+}
+
+PatientModel::~PatientModel()
+{
+    m_loaderThread.quit();
+    m_loaderThread.wait();
 }
 
 QHash<int, QByteArray> PatientModel::roleNames() const
@@ -77,6 +105,35 @@ bool PatientModel::setData(const QModelIndex &index, const QVariant &value, int
     return obj->setProperty(prop.constData(), value);
 }
 
+bool PatientModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > m_objects.size()) {
+        return false;
+    }
+
+    // Pending changes refer to the current rows, get them out before the rows shift.
+    m_changeTimer.stop();
+    flushChanges();
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    for (auto it = m_objects.cbegin() + row; it != m_objects.cbegin() + row + count; ++it) {
+        m_rows.remove(*it);
+        delete *it;
+    }
+    m_objects.remove(row, count);
+    for (int i = row; i < m_objects.size(); ++i) {
+        m_rows[m_objects.at(i)] = i;
+    }
+    endRemoveRows();
+
+    if (m_currentIndex >= row + count) {
+        setCurrentIndex(m_currentIndex - count);
+    } else if (m_currentIndex >= row) {
+        setCurrentIndex(-1);
+    }
+    return true;
+}
+
 int PatientModel::role(const QByteArray &roleName) const
 {
     return m_roles.key(roleName, -1);
@@ -86,24 +143,40 @@ void PatientModel::addObject(std::unique_ptr<Patient> patient)
 {
     const int index = m_objects.size();
     beginInsertRows(QModelIndex(), index, index);
+    appendObject(patient.release());
+    endInsertRows();
+}
 
-    auto object = patient.release();
-    object->setParent(this);
+void PatientModel::addPatients(const QList<PatientData> &patients)
+{
+    if (patients.isEmpty()) {
+        return;
+    }
 
-    m_objects.append(object);
+    const int first = m_objects.size();
+    beginInsertRows(QModelIndex(), first, first + int(patients.size()) - 1);
+    m_objects.reserve(m_objects.size() + patients.size());
+    m_rows.reserve(m_objects.size() + patients.size());
+    for (const auto &data : patients) {
+        appendObject(new Patient(data));
+    }
+    endInsertRows();
+}
+
+void PatientModel::appendObject(Patient *object)
+{
     Q_ASSERT(!m_roles.isEmpty());
 
-    const QMetaObject *mo = object->metaObject();
+    object->setParent(this);
+    m_rows.insert(object, int(m_objects.size()));
+    m_objects.append(object);
+
     // We have all the data changed notify signals already stored, let's connect all changed signals to our property change wrapper.
-    const QList<int> signalIndices = m_signalIndexToProperties.keys();
-    for (const auto &signalMethodIndex : signalIndices) {
-        const QMetaMethod meth = mo->method(signalMethodIndex);
-        // Since we dynamically connect all relevant change signals through QMetaMethods we also need the slot to be a QMM. Unfortunate since this is
-        // a bit fiddly.
-        connect(object, meth, this, propertyChangedMetaMethod());
+    // Since we dynamically connect all relevant change signals through QMetaMethods we also need the slot to be a QMM. Unfortunate since this is
+    // a bit fiddly.
+    for (const auto &signal : std::as_const(m_notifySignals)) {
+        connect(object, signal, this, m_propertyChangedSlot);
     }
-
-    endInsertRows();
 }
 
 QMetaMethod PatientModel::propertyChangedMetaMethod() const
@@ -124,12 +197,40 @@ QMetaMethod PatientModel::propertyChangedMetaMethod() const
 void PatientModel::propertyChanged()
 {
     // Property index and role index are the same so we only need to map the signal index to the property index.
-    const int role = m_signalIndexToProperties.value(senderSignalIndex(), -1);
-    Q_ASSERT(role != -1);
-    const int index = m_objects.indexOf(sender());
+    const auto roles = m_signalIndexToProperties.value(senderSignalIndex());
+    Q_ASSERT(!roles.isEmpty());
+    const int index = m_rows.value(sender(), -1);
     Q_ASSERT(index != -1);
-    qDebug() << "PROPERTY CHANGED (" << index << ") :: " << role << roleNames().value(role);
-    Q_EMIT dataChanged(createIndex(index, 0), createIndex(index, 0), {role});
+    m_changedRows.insert(index);
+    for (const auto &role : roles) {
+        m_changedRoles.insert(role);
+    }
+    if (!m_changeTimer.isActive()) {
+        m_changeTimer.start();
+    }
+}
+
+void PatientModel::flushChanges()
+{
+    if (m_changedRows.isEmpty()) {
+        return;
+    }
+
+    QList<int> rows(m_changedRows.cbegin(), m_changedRows.cend());
+    std::ranges::sort(rows);
+    const QList<int> roles(m_changedRoles.cbegin(), m_changedRoles.cend());
+    m_changedRows.clear();
+    m_changedRoles.clear();
+
+    // The roles are the union over all rows. Slightly over-reporting is much cheaper than one emission per row.
+    for (auto first = rows.cbegin(); first != rows.cend();) {
+        auto last = first;
+        while (std::next(last) != rows.cend() && *std::next(last) == *last + 1) {
+            ++last;
+        }
+        Q_EMIT dataChanged(index(*first), index(*last), roles);
+        first = std::next(last);
+    }
 }
 
 int PatientModel::initRoleNames(const QMetaObject &mo)
@@ -146,7 +247,11 @@ int PatientModel::initRoleNames(const QMetaObject &mo)
         if (!property.hasNotifySignal()) {
             continue;
         }
-        m_signalIndexToProperties.insert(property.notifySignalIndex(), maxEnumValue);
+        auto &roles = m_signalIndexToProperties[property.notifySignalIndex()];
+        if (roles.isEmpty()) {
+            m_notifySignals.append(property.notifySignal());
+        }
+        roles.append(maxEnumValue);
     }
     return maxEnumValue;
 }
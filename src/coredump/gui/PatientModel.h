@@ -8,7 +8,11 @@
 #include "Patient.h"
 
 #include <QAbstractListModel>
+#include <QMetaMethod>
 #include <QQmlEngine>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
 
 class PatientModel : public QAbstractListModel
 {
@@ -35,17 +39,24 @@ public:
     static PatientModel *create(QQmlEngine *, QJSEngine *)
     {
         QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
+        instance()->load();
         return instance();
     }
 
+    // Starts loading patients from the journal. Only the first call has any effect.
+    void load();
+
     [[nodiscard]] QHash<int, QByteArray> roleNames() const final;
     [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const final;
     [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
     [[nodiscard]] int role(const QByteArray &roleName) const;
 
     // Takes ownership.
     void addObject(std::unique_ptr<Patient> patient);
+    // Inserts all of them with a single row insertion.
+    void addPatients(const QList<PatientData> &patients);
 
     Q_PROPERTY(bool ready READ ready WRITE setReady NOTIFY readyChanged)
     bool ready() const;
@@ -62,16 +73,31 @@ private Q_SLOTS:
     void propertyChanged();
 
 private:
+    // Emits the changes recorded by propertyChanged as one dataChanged per contiguous row range.
+    void flushChanges();
     int initRoleNames(const QMetaObject &mo);
     void addDynamicRoleNames(int maxEnumValue, QObject *object);
     [[nodiscard]] QMetaMethod propertyChangedMetaMethod() const;
     explicit PatientModel(QObject *parent = nullptr);
+    ~PatientModel() override;
+    // Appends without announcing the row insertion, that is up to the caller.
+    void appendObject(Patient *object);
 
     int m_currentIndex = -1;
 
     QList<Patient *> m_objects;
+    // Reverse of m_objects so we can find the row of a sender without a linear search.
+    QHash<const QObject *, int> m_rows;
     QHash<int, QByteArray> m_roles;
     QHash<int, QByteArray> m_objectProperties;
-    QHash<int, int> m_signalIndexToProperties;
+    // Multiple properties may share the same notify signal.
+    QHash<int, QList<int>> m_signalIndexToProperties;
+    QList<QMetaMethod> m_notifySignals;
+    QMetaMethod m_propertyChangedSlot;
+    QSet<int> m_changedRows;
+    QSet<int> m_changedRoles;
+    QTimer m_changeTimer;
     bool m_ready = false;
+    bool m_loading = false;
+    QThread m_loaderThread;
 };
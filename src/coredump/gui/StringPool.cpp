@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "StringPool.h"
+
+#include <QMutex>
+#include <QSet>
+
+namespace
+{
+template<typename String>
+String intern(const String &string)
+{
+    static QMutex mutex;
+    static QSet<String> pool;
+
+    if (string.isEmpty()) {
+        return {};
+    }
+
+    const QMutexLocker locker(&mutex);
+    if (const auto it = pool.constFind(string); it != pool.cend()) {
+        return *it;
+    }
+    // Always a deep copy. The input may be raw data referring into a buffer we don't control (QByteArray::fromRawData).
+    const String copy(string.constData(), string.size());
+    pool.insert(copy);
+    return copy;
+}
+} // namespace
+
+QString StringPool::intern(const QString &string)
+{
+    return ::intern(string);
+}
+
+QByteArray StringPool::intern(const QByteArray &string)
+{
+    return ::intern(string);
+}
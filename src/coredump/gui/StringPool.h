@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Crash histories are full of duplicates (the same application crashing over and over). Interning makes all of them
+// share a single implicitly shared copy. Thread-safe.
+namespace StringPool
+{
+[[nodiscard]] QString intern(const QString &string);
+[[nodiscard]] QByteArray intern(const QByteArray &string);
+} // namespace StringPool
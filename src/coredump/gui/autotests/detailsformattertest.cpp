@@ -0,0 +1,58 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "../DetailsFormatter.h"
+
+using namespace Qt::StringLiterals;
+
+class DetailsFormatterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFormat()
+    {
+        const QHash<QByteArray, QByteArray> fields{
+            {"COREDUMP_PID"_ba, "1234"_ba},
+            {"COREDUMP_COMM"_ba, "konqi"_ba},
+            {"COREDUMP_SIGNAL"_ba, "11"_ba},
+            {"COREDUMP_SIGNAL_NAME"_ba, "SIGSEGV"_ba},
+            {"COREDUMP_EXE"_ba, "/usr/bin/konqi"_ba},
+            {"COREDUMP_FILENAME"_ba, "/nonexistent/core.konqi.zst"_ba},
+            {"MESSAGE"_ba, "Process 1234 (konqi) dumped core.\n\nStack trace of thread 1234:\n#0  0x0000 n/a (n/a + 0x0)"_ba},
+        };
+        const auto output = DetailsFormatter::format(fields);
+        QVERIFY2(output.startsWith("           PID: 1234 (konqi)\n"_L1), qPrintable(output));
+        QVERIFY(output.contains("        Signal: 11 (SEGV)\n"_L1));
+        QVERIFY(output.contains("    Executable: /usr/bin/konqi\n"_L1));
+        QVERIFY(output.contains("       Storage: /nonexistent/core.konqi.zst (missing)\n"_L1));
+        // Continuation lines are aligned with the first line of the value, empty ones stay empty.
+        QVERIFY(output.endsWith(
+            "       Message: Process 1234 (konqi) dumped core.\n\n                Stack trace of thread 1234:\n                #0  0x0000 n/a (n/a + 0x0)\n"_L1));
+        QVERIFY(!output.contains("Command Line"_L1));
+        QVERIFY(!DetailsFormatter::needsCoredumpctl(fields));
+    }
+
+    void testNeedsCoredumpctl()
+    {
+        QTemporaryFile core;
+        QVERIFY(core.open());
+        QHash<QByteArray, QByteArray> fields{
+            {"COREDUMP_FILENAME"_ba, core.fileName().toUtf8()},
+            {"MESSAGE"_ba, "Process 1234 (konqi) dumped core."_ba},
+        };
+        // No stack trace in the journal, but coredumpctl can get one from the core.
+        QVERIFY(DetailsFormatter::needsCoredumpctl(fields));
+        fields["COREDUMP_FILENAME"_ba] = "/nonexistent/core.konqi.zst"_ba;
+        QVERIFY(!DetailsFormatter::needsCoredumpctl(fields));
+    }
+};
+
+QTEST_GUILESS_MAIN(DetailsFormatterTest)
+
+#include "detailsformattertest.moc"
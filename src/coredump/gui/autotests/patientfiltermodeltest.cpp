@@ -0,0 +1,106 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../Patient.h"
+#include "../PatientFilterModel.h"
+#include "../PatientModel.h"
+#include "patienttestutils.h"
+
+using namespace Qt::StringLiterals;
+using namespace PatientTestUtils;
+
+namespace
+{
+constexpr auto PATIENT_COUNT = 100'000;
+constexpr auto APPLICATION_COUNT = 100;
+} // namespace
+
+class PatientFilterModelTest : public QObject
+{
+    Q_OBJECT
+
+    PatientModel *m_model = PatientModel::instance();
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_model->addPatients(makePatients(PATIENT_COUNT, APPLICATION_COUNT));
+    }
+
+    void cleanupTestCase()
+    {
+        m_model->removeRows(0, m_model->rowCount());
+    }
+
+    void testNewestFirst()
+    {
+        PatientFilterModel filter;
+        filter.setSourceModel(m_model);
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT);
+        QCOMPARE(patientAt(filter, 0)->timestamp(), time_t(PATIENT_COUNT - 1));
+        QCOMPARE(patientAt(filter, PATIENT_COUNT - 1)->timestamp(), time_t(0));
+    }
+
+    void testSearch()
+    {
+        PatientFilterModel filter;
+        filter.setSourceModel(m_model);
+
+        filter.setFilterString(u"KONQI4"_s); // case insensitive
+        QCOMPARE(filter.rowCount(), 11 * PATIENT_COUNT / APPLICATION_COUNT); // 4 and 40-49
+        filter.setFilterString(u"konqi42"_s);
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT / APPLICATION_COUNT);
+        QCOMPARE(patientAt(filter, 0)->appName(), u"konqi42"_s);
+        // Widening again must bring back what narrowing dropped.
+        filter.setFilterString(u"konqi4"_s);
+        QCOMPARE(filter.rowCount(), 11 * PATIENT_COUNT / APPLICATION_COUNT);
+        filter.setFilterString(u"sigabrt"_s);
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT / 2);
+        filter.setFilterString(u"/usr/bin/konqi99"_s);
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT / APPLICATION_COUNT);
+        filter.setFilterString({});
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT);
+    }
+
+    void testGroupByApplication()
+    {
+        PatientFilterModel filter;
+        filter.setSourceModel(m_model);
+        QSignalSpy spy(&filter, &PatientFilterModel::applicationCountsChanged);
+        filter.setFilterString(u"konqi1"_s);
+        filter.setGroupByApplication(true);
+
+        // konqi1 and konqi10-19, alphabetically, newest first within each.
+        QCOMPARE(patientAt(filter, 0)->appName(), u"konqi1"_s);
+        QCOMPARE(patientAt(filter, 0)->timestamp(), time_t(PATIENT_COUNT - APPLICATION_COUNT + 1));
+        QCOMPARE(patientAt(filter, PATIENT_COUNT / APPLICATION_COUNT)->appName(), u"konqi10"_s);
+
+        QTRY_VERIFY(!spy.isEmpty());
+        const auto counts = filter.applicationCounts();
+        QCOMPARE(counts.size(), 11);
+        QCOMPARE(counts.value(u"konqi12"_s).toInt(), PATIENT_COUNT / APPLICATION_COUNT);
+    }
+
+    void benchmarkTyping()
+    {
+        PatientFilterModel filter;
+        filter.setSourceModel(m_model);
+        const QStringList keystrokes{u"k"_s, u"ko"_s, u"kon"_s, u"konq"_s, u"konqi"_s, u"konqi4"_s, u"konqi42"_s};
+        QBENCHMARK {
+            for (const auto &text : keystrokes) {
+                filter.setFilterString(text);
+            }
+            filter.setFilterString({});
+        }
+        QCOMPARE(filter.rowCount(), PATIENT_COUNT);
+    }
+};
+
+QTEST_GUILESS_MAIN(PatientFilterModelTest)
+
+#include "patientfiltermodeltest.moc"
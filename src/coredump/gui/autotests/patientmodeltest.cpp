@@ -0,0 +1,111 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../Patient.h"
+#include "../PatientModel.h"
+#include "patienttestutils.h"
+
+using namespace PatientTestUtils;
+
+namespace
+{
+constexpr auto PATIENT_COUNT = 50'000;
+} // namespace
+
+class PatientModelTest : public QObject
+{
+    Q_OBJECT
+
+    PatientModel *m_model = PatientModel::instance();
+
+private Q_SLOTS:
+    void cleanup()
+    {
+        m_model->removeRows(0, m_model->rowCount());
+        QCOMPARE(m_model->rowCount(), 0);
+    }
+
+    void testCoalescedChanges()
+    {
+        m_model->addPatients(makePatients(10));
+        QSignalSpy spy(m_model, &PatientModel::dataChanged);
+
+        for (const auto row : {2, 3, 4, 7}) {
+            Q_EMIT patientAt(*m_model, row)->changed();
+        }
+        Q_EMIT patientAt(*m_model, 3)->changed(); // same row twice
+        QTRY_COMPARE(spy.count(), 2);
+
+        QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 2);
+        QCOMPARE(spy.at(0).at(1).toModelIndex().row(), 4);
+        QCOMPARE(spy.at(1).at(0).toModelIndex().row(), 7);
+        QCOMPARE(spy.at(1).at(1).toModelIndex().row(), 7);
+        // All properties notifying through the changed signal must be listed, not just one of them.
+        const auto roles = spy.at(0).at(2).value<QList<int>>();
+        QVERIFY(roles.contains(m_model->role("ROLE_appName"_ba)));
+        QVERIFY(roles.contains(m_model->role("ROLE_reported"_ba)));
+    }
+
+    void testRemove()
+    {
+        m_model->addPatients(makePatients(10));
+        m_model->setCurrentIndex(8);
+        auto patient = patientAt(*m_model, 8);
+
+        QVERIFY(m_model->removeRows(2, 3));
+        QCOMPARE(m_model->rowCount(), 7);
+        QCOMPARE(m_model->currentIndex(), 5);
+        QCOMPARE(m_model->currentPatient(), patient);
+
+        // The row lookup must have moved along with the rows.
+        QSignalSpy spy(m_model, &PatientModel::dataChanged);
+        Q_EMIT patient->changed();
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 5);
+
+        QVERIFY(m_model->removeRows(4, 2));
+        QCOMPARE(m_model->currentIndex(), -1);
+        QVERIFY(!m_model->removeRows(4, 10));
+    }
+
+    void benchmarkPopulate()
+    {
+        const auto patients = makePatients(PATIENT_COUNT);
+        QBENCHMARK {
+            m_model->addPatients(patients);
+            QCOMPARE(m_model->rowCount(), PATIENT_COUNT);
+            m_model->removeRows(0, m_model->rowCount());
+        }
+    }
+
+    void benchmarkUpdate()
+    {
+        m_model->addPatients(makePatients(PATIENT_COUNT));
+        QList<Patient *> patients;
+        patients.reserve(PATIENT_COUNT);
+        for (int row = 0; row < PATIENT_COUNT; ++row) {
+            patients.append(patientAt(*m_model, row));
+        }
+
+        QSignalSpy spy(m_model, &PatientModel::dataChanged);
+        QBENCHMARK {
+            spy.clear();
+            // Back to front to make sure the lookup doesn't benefit from scanning order.
+            for (auto it = patients.crbegin(); it != patients.crend(); ++it) {
+                Q_EMIT (*it)->changed();
+            }
+            QTRY_COMPARE(spy.count(), 1);
+        }
+        QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+        QCOMPARE(spy.at(0).at(1).toModelIndex().row(), PATIENT_COUNT - 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(PatientModelTest)
+
+#include "patientmodeltest.moc"
@@ -0,0 +1,47 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#pragma once
+
+#include <limits>
+
+#include <QAbstractItemModel>
+#include <QList>
+
+#include "../Patient.h"
+#include "../PatientModel.h"
+
+namespace PatientTestUtils
+{
+// Patient i is application konqi<i % applicationCount> (i.e. by default every patient is its own application),
+// crashed with timestamp i and alternates between SIGSEGV and SIGABRT.
+[[nodiscard]] inline QList<PatientData> makePatients(int count, int applicationCount = std::numeric_limits<int>::max())
+{
+    using namespace Qt::StringLiterals;
+
+    QList<PatientData> patients;
+    patients.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const auto application = u"konqi%1"_s.arg(i % applicationCount);
+        patients.append(PatientData{
+            .origCoreFilename = {},
+            .signal = i % 2 == 0 ? 11 : 6,
+            .appName = application,
+            .pid = pid_t(i + 1),
+            .timestamp = time_t(i),
+            .coredumpExe = "/usr/bin/"_ba + application.toUtf8(),
+            .coredumpCom = application.toUtf8(),
+            .faultContext = {},
+            .journalCursor = u"s=%1"_s.arg(i),
+        });
+    }
+    return patients;
+}
+
+[[nodiscard]] inline Patient *patientAt(const QAbstractItemModel &model, int row)
+{
+    return model.data(model.index(row, 0), PatientModel::ObjectRole).value<Patient *>();
+}
+} // namespace PatientTestUtils
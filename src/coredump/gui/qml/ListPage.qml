@@ -5,7 +5,6 @@ import QtQuick
 import QtQuick.Controls as QQC2
 import QtQuick.Layouts
 import org.kde.kirigami as Kirigami
-import org.kde.kitemmodels as KItemModels
 
 import org.kde.drkonqi.coredump.gui as DrKonqi
 
@@ -18,6 +17,20 @@ Kirigami.ScrollablePage {
             displayComponent: Kirigami.SearchField {
                 onAccepted: patientFilterModel.filterString = text
             }
+        },
+        Kirigami.Action {
+            icon.name: "view-group"
+            text: i18nc("@action:intoolbar", "Group by Application")
+            checkable: true
+            checked: patientFilterModel.groupByApplication
+            onToggled: patientFilterModel.groupByApplication = checked
+        },
+        Kirigami.Action {
+            icon.name: "document-send"
+            text: i18nc("@action:intoolbar", "Show Reported")
+            checkable: true
+            checked: patientFilterModel.showReported
+            onToggled: patientFilterModel.showReported = checked
         }
     ]
 
@@ -28,12 +41,18 @@ Kirigami.ScrollablePage {
 
         reuseItems: true // We have a lot of items potentially, recycle them
 
-        KItemModels.KSortFilterProxyModel { // set as model during state change
+        DrKonqi.PatientFilterModel { // set as model during state change
             id: patientFilterModel
             sourceModel: DrKonqi.PatientModel
-            filterRoleName: "ROLE_appName"
-            sortRoleName: "modelIndex"
-            sortOrder: Qt.DescendingOrder
+        }
+
+        section.property: patientFilterModel.groupByApplication ? "ROLE_appName" : ""
+        section.criteria: ViewSection.FullString
+        section.delegate: Kirigami.ListSectionHeader {
+            required property string section
+
+            width: ListView.view.width
+            text: i18nc("@title:group %1 is an application name, %2 the number of its crashes", "%1 (%2)", section, patientFilterModel.applicationCounts[section] ?? 0)
         }
 
         onCountChanged: {
@@ -0,0 +1,123 @@
+/*
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include "journalentry.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <QByteArrayView>
+#include <QDebug>
+#include <QList>
+
+#include "memory.h"
+
+namespace
+{
+[[nodiscard]] std::unique_ptr<sd_journal> openAt(const QByteArray &cursor)
+{
+    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open, SD_JOURNAL_LOCAL_ONLY);
+    if (expectedJournal.ret != 0) {
+        qWarning() << "Failed to open journal:" << strerror(-expectedJournal.ret);
+        return nullptr;
+    }
+    auto journal = std::move(expectedJournal.value);
+    if (sd_journal_seek_cursor(journal.get(), cursor.constData()) != 0 || sd_journal_next(journal.get()) <= 0
+        || sd_journal_test_cursor(journal.get(), cursor.constData()) <= 0) {
+        qWarning() << "Failed to find journal entry" << cursor;
+        return nullptr;
+    }
+    // We are here to get the full data.
+    sd_journal_set_data_threshold(journal.get(), 0);
+    return journal;
+}
+
+// Returns the value part of KEY=VALUE field data
+[[nodiscard]] std::optional<QByteArrayView> getValue(sd_journal *journal, const QByteArray &key)
+{
+    const void *data = nullptr;
+    size_t length = 0;
+    if (sd_journal_get_data(journal, key.constData(), &data, &length) != 0) {
+        return std::nullopt;
+    }
+    const QByteArrayView field(static_cast<const char *>(data), static_cast<qsizetype>(length));
+    Q_ASSERT(field.startsWith(key + '='));
+    return field.sliced(key.size() + 1);
+}
+} // namespace
+
+std::optional<QHash<QByteArray, QByteArray>> JournalEntry::fields(const QByteArray &cursor)
+{
+    const auto journal = openAt(cursor);
+    if (!journal) {
+        return std::nullopt;
+    }
+
+    // Enumerate with a threshold so the core doesn't get decompressed just to be thrown away. Anything that got cut
+    // off by the threshold is fetched again in full afterwards.
+    constexpr size_t threshold = 64 * 1024;
+    sd_journal_set_data_threshold(journal.get(), threshold);
+    QHash<QByteArray, QByteArray> fields;
+    QList<QByteArray> truncated;
+    const void *data = nullptr;
+    size_t length = 0;
+    SD_JOURNAL_FOREACH_DATA(journal.get(), data, length)
+    {
+        const QByteArrayView field(static_cast<const char *>(data), static_cast<qsizetype>(length));
+        const auto separator = field.indexOf('=');
+        if (separator <= 0) {
+            continue;
+        }
+        const auto key = field.first(separator).toByteArray();
+        if (key == "COREDUMP") {
+            continue;
+        }
+        if (length >= threshold) {
+            truncated.append(key);
+            continue;
+        }
+        fields.insert(key, field.sliced(separator + 1).toByteArray());
+    }
+
+    sd_journal_set_data_threshold(journal.get(), 0);
+    for (const auto &key : std::as_const(truncated)) {
+        if (const auto value = getValue(journal.get(), key); value.has_value()) {
+            fields.insert(key, value->toByteArray());
+        }
+    }
+    return fields;
+}
+
+bool JournalEntry::streamCore(const QByteArray &cursor, int fd)
+{
+    const auto journal = openAt(cursor);
+    if (!journal) {
+        return false;
+    }
+    // NB: the view is only valid until the next journal call!
+    const auto core = getValue(journal.get(), QByteArrayLiteral("COREDUMP"));
+    if (!core.has_value()) {
+        qWarning() << "Entry has no core stored in the journal" << cursor;
+        return false;
+    }
+
+    const char *position = core->data();
+    auto remaining = static_cast<size_t>(core->size());
+    while (remaining > 0) {
+        const auto written = write(fd, position, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "Failed to write core:" << strerror(errno);
+            return false;
+        }
+        position += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+}
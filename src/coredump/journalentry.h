@@ -0,0 +1,23 @@
+/*
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#pragma once
+
+#include <optional>
+
+#include <QByteArray>
+#include <QHash>
+
+// Random access to single journal entries by cursor. Complements the CoredumpWatcher's field projection: fields that
+// weren't projected (or got cut off by the data threshold) can be fetched here when they are actually needed.
+namespace JournalEntry
+{
+// Reads all fields in full, except for the core itself (COREDUMP=) should it be stored in the journal.
+// Returns nullopt when the entry doesn't exist.
+[[nodiscard]] std::optional<QHash<QByteArray, QByteArray>> fields(const QByteArray &cursor);
+// Writes the COREDUMP= field of a core stored in the journal (Storage=journal in coredump.conf) to fd.
+// The data is written straight out of the journal's buffer, it never gets copied into a QByteArray.
+[[nodiscard]] bool streamCore(const QByteArray &cursor, int fd);
+} // namespace JournalEntry
@@ -3,7 +3,6 @@
 
 #include "DevNotifierTruck.h"
 
-#include <QCoreApplication>
 #include <QFile>
 #include <QProcess>
 #include <QTimer>
@@ -16,7 +15,7 @@
 using namespace std::chrono_literals;
 using namespace Qt::StringLiterals;
 
-bool DevNotifierTruck::handle(const Coredump &dump)
+bool DevNotifierTruck::handle(const Coredump &dump, Done done)
 {
     if (!dump.m_rawData.value(dump.keyPickup()).isEmpty()) {
         // Pickups are currently not supported for notify handling. The problem is that we don't know if we already
@@ -26,17 +25,25 @@ bool DevNotifierTruck::handle(const Coredump &dump)
         return false;
     }
 
+    // We are done once the notification is done with. Connections are made in a context object that goes away with
+    // that so nothing calls into a finished dump when the launcher lives on for further dumps.
+    auto context = new QObject(this);
+    auto finish = [context, done = once(std::move(done))] {
+        context->deleteLater();
+        done();
+    };
+
     auto notification = new KNotification(u"applicationCrash"_s);
 
     // immediate exit signal. This gets disconnected should `activated` arrive first (in that case we
     // want to wait for the terminal app to start and not exit on further notification signals)
-    QObject::connect(notification, &KNotification::closed, this, [this, notification] {
-        notification->disconnect(this);
-        qApp->exit(0);
+    QObject::connect(notification, &KNotification::closed, context, [context, finish, notification] {
+        notification->disconnect(context);
+        finish();
     });
-    QObject::connect(notification, &QObject::deleteLater, this, [this, notification] {
-        notification->disconnect(this);
-        qApp->exit(0);
+    QObject::connect(notification, &QObject::deleteLater, context, [context, finish, notification] {
+        notification->disconnect(context);
+        finish();
     });
 
     if (!QFile::exists(dump.filename)) {
@@ -49,35 +56,33 @@ bool DevNotifierTruck::handle(const Coredump &dump)
 
         const auto pid = dump.pid;
 
-        connect(gdbAction, &KNotificationAction::activated, notification, [pid, this, notification]() {
-            notification->disconnect(this);
+        connect(gdbAction, &KNotificationAction::activated, context, [pid, this, context, finish, notification]() {
+            notification->disconnect(context);
             auto job = new KTerminalLauncherJob(QStringLiteral("coredumpctl gdb %1").arg(QString::number(pid)), this);
             job->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
-            connect(job, &KJob::result, this, [job] {
+            connect(job, &KJob::result, context, [job, finish] {
                 if (job->error() != KJob::NoError) {
                     qWarning() << job->errorText();
                 }
-                qApp->exit(0);
+                finish();
             });
             job->start();
 
             // Just in case the launcher job bugs out also add a timer.
-            auto startTimeout = new QTimer(this);
+            auto startTimeout = new QTimer(context);
             startTimeout->setInterval(16s);
-            connect(startTimeout, &QTimer::timeout, this, [] {
-                qApp->exit(0);
-            });
+            startTimeout->setSingleShot(true);
+            connect(startTimeout, &QTimer::timeout, context, finish);
             startTimeout->start();
         });
     }
 
+    if (dump.crashCount > 1) {
+        notification->setText(notification->text() + QStringLiteral(" (crashed %1 times)").arg(QString::number(dump.crashCount)));
+    }
+
     notification->setFlags(KNotification::DefaultEvent | KNotification::SkipGrouping);
     notification->sendEvent();
-
-    // KNotification internally depends on an eventloop to communicate over dbus. We therefore start the
-    // eventloop here. ::handle() is expected to be blocking so this has no adverse effects.
-    // The eventloop is either exited when the notification gets closed or when the debugger has started.
-    qApp->exec();
     return true;
 }
 
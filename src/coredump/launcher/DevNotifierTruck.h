@@ -15,5 +15,5 @@ class DevNotifierTruck : public QObject, public DumpTruckInterface
     Q_OBJECT
 public:
     using QObject::QObject;
-    [[nodiscard]] bool handle(const Coredump &dump) override;
+    [[nodiscard]] bool handle(const Coredump &dump, Done done) override;
 };
@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <utility>
+
 #include <QtPlugin>
 
 class Coredump;
@@ -12,8 +16,31 @@ class Coredump;
 class DumpTruckInterface
 {
 public:
+    using Done = std::function<void()>;
+
     DumpTruckInterface() = default;
     virtual ~DumpTruckInterface() = default;
     Q_DISABLE_COPY_MOVE(DumpTruckInterface)
-    [[nodiscard]] virtual bool handle(const Coredump &dump) = 0;
+    // Returns whether the truck takes care of the dump. Trucks don't block, when they take care of a dump they invoke
+    // done once they are finished with it. That may be before handle() returns.
+    [[nodiscard]] virtual bool handle(const Coredump &dump, Done done) = 0;
+
+    // done runs once the last copy of the returned locker is gone. Lets the lambdas that make up the handling of a dump
+    // share one completion, akin to QEventLoopLocker.
+    [[nodiscard]] static std::shared_ptr<void> locker(Done done)
+    {
+        return {nullptr, [done = std::move(done)](void *) {
+                    done();
+                }};
+    }
+
+    // Wraps done so it runs only once, however many of the signals it is connected to fire.
+    [[nodiscard]] static Done once(Done done)
+    {
+        return [done = std::make_shared<Done>(std::move(done))] {
+            if (auto callback = std::exchange(*done, nullptr)) {
+                callback();
+            }
+        };
+    }
 };
@@ -3,10 +3,7 @@
 
 #include "GlobalNotifierTruck.h"
 
-#include <QCoreApplication>
 #include <QFile>
-#include <QFileInfo>
-#include <QStandardPaths>
 
 #include <KIO/CommandLauncherJob>
 #include <KLocalizedString>
@@ -14,40 +11,11 @@
 #include <KService>
 
 #include "../coredump.h"
-#include "decode.h"
+#include "serviceindex.h"
 
 using namespace Qt::StringLiterals;
 
-namespace
-{
-KService::Ptr serviceForUnitName(const QString &unitName)
-{
-    auto serviceName = unitNameToServiceName(unitName);
-    if (serviceName.isEmpty()) {
-        return {};
-    }
-
-    if (auto service = KService::serviceByMenuId(serviceName.toString() + ".desktop"_L1); service) {
-        if (service->categories().contains("TerminalEmulator"_L1)) {
-            // Terminals most of the time host applications in their own cgroup, making it impossible to detect the
-            // correct service, if any.
-            return {};
-        }
-        return service;
-    }
-    if (unitName.endsWith("@autostart.service"_L1)) {
-        if (auto file = QStandardPaths::locate(QStandardPaths::GenericConfigLocation, u"autostart/%1.desktop"_s.arg(serviceName)); !file.isEmpty()) {
-            if (auto service = new KService(file); service->isValid()) {
-                return KService::Ptr(service);
-            }
-        }
-    }
-
-    return {};
-}
-} // namespace
-
-bool GlobalNotifierTruck::handle(const Coredump &dump)
+bool GlobalNotifierTruck::handle(const Coredump &dump, Done done)
 {
 #if !defined(WITH_GLOBAL_NOTIFIER)
     return false;
@@ -65,7 +33,7 @@ bool GlobalNotifierTruck::handle(const Coredump &dump)
         Unit(const QStringView &exe, const QByteArrayView &cursor, const QByteArrayView &systemUnit, const QByteArrayView &userUnit)
             : m_cursor(QString::fromUtf8(cursor))
             , m_name(QString::fromUtf8(userUnit.isEmpty() ? systemUnit : userUnit))
-            , m_service(serviceForUnitName(m_name))
+            , m_service(ServiceIndex::self()->serviceForUnitName(m_name))
             , m_exe(exe)
         {
         }
@@ -93,8 +61,10 @@ bool GlobalNotifierTruck::handle(const Coredump &dump)
         QString m_exe;
     };
 
-    // Be mindful of when QEventLoopLocker start and when they end! Specifically lambdas need suitable scoping so they eventually get destroyed.
-    qApp->setQuitLockEnabled(true);
+    // Be mindful of when lockers start and when they end! Specifically lambdas need suitable scoping so they eventually get destroyed.
+    // We are done with the dump once the last locker is gone. Not the application's QEventLoopLocker, the launcher may
+    // live on to handle further dumps.
+    const auto locker = DumpTruckInterface::locker(std::move(done));
 
     // Mind that m_cursor of the dump is empty because we don't resolve this from the journal but receive it as json from the processor.
     // As such we need to fetch the cursor from the payload. NOT the dump directly.
@@ -115,18 +85,25 @@ bool GlobalNotifierTruck::handle(const Coredump &dump)
         notification->setText(
             xi18nc("@info notification text. %1 is a exe name", "<command>%1</command> has encountered a fatal error and was closed.", dump.exe));
     }
+    if (dump.crashCount > 1) {
+        notification->setText(notification->text() + u' '
+                              + i18ncp("@info notification text appended to the crash text",
+                                       "It crashed %1 time in quick succession.",
+                                       "It crashed %1 times in quick succession.",
+                                       dump.crashCount));
+    }
 
     auto detailsAction = notification->addAction(i18nc("@action:button show crash details", "Details"));
-    connect(detailsAction, &KNotificationAction::activated, notification, [this, unit, loopLocker = QEventLoopLocker()]() {
+    connect(detailsAction, &KNotificationAction::activated, notification, [this, unit, locker]() {
         auto job = new KIO::CommandLauncherJob(u"drkonqi-coredump-gui"_s, {unit.m_cursor}, this);
-        connect(job, &KJob::result, job, [loopLocker = QEventLoopLocker()](KJob *job) {
+        connect(job, &KJob::result, job, [locker](KJob *job) {
             if (job->error()) {
                 auto errorNotification = KNotification::event(KNotification::Error,
                                                               i18nc("@title", "Failed to Launch"),
                                                               i18nc("@info", "Could not launch the Crashed Process Viewer."),
                                                               u"tools-report-bug"_s);
-                connect(errorNotification, &KNotification::destroyed, errorNotification, [loopLocker = QEventLoopLocker()]() {
-                    // Only here to scope the loopLocker. Nothing to actually do.
+                connect(errorNotification, &KNotification::destroyed, errorNotification, [locker]() {
+                    // Only here to scope the locker. Nothing to actually do.
                 });
                 errorNotification->sendEvent();
                 qWarning() << "Failed to launch drkonqi-coredump-gui:" << job->errorString();
@@ -136,11 +113,6 @@ bool GlobalNotifierTruck::handle(const Coredump &dump)
     });
 
     notification->sendEvent();
-
-    // KNotification internally depends on an eventloop to communicate over dbus. We therefore start the
-    // eventloop here. ::handle() is expected to be blocking so this has no adverse effects.
-    // The eventloop is either exited when the notification gets closed or when the debugger has started.
-    qApp->exec();
     return true;
 }
 
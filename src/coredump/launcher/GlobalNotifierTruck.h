@@ -12,5 +12,5 @@ class GlobalNotifierTruck : public QObject, public DumpTruckInterface
     Q_OBJECT
 public:
     using QObject::QObject;
-    [[nodiscard]] bool handle(const Coredump &dump) override;
+    [[nodiscard]] bool handle(const Coredump &dump, Done done) override;
 };
@@ -0,0 +1,16 @@
+# SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+# SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+[Unit]
+Description=Launch DrKonqi for systemd-coredump crashes (long-lived launcher)
+PartOf=graphical-session.target
+Requisite=graphical-session.target
+ConditionUser=!@system
+
+[Service]
+# Don't need to be working anywhere specific, use tmp.
+WorkingDirectory=%T
+# Exits by itself after this many minutes without dumps. The socket starts it again when needed.
+ExecStart=@KDE_INSTALL_FULL_LIBEXECDIR@/drkonqi-coredump-launcher --idle-exit 10
+Slice=app.slice
+Restart=no
@@ -3,12 +3,20 @@
     SPDX-FileCopyrightText: 2019-2022 Harald Sitter <sitter@kde.org>
 */
 
-#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
 #include <systemd/sd-daemon.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
 
+#include <QCommandLineParser>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -17,7 +25,9 @@
 #include <QLibraryInfo>
 #include <QProcess>
 #include <QScopeGuard>
+#include <QSocketNotifier>
 #include <QStandardPaths>
+#include <QTimer>
 
 #include <KConfig>
 #include <KConfigGroup>
@@ -26,6 +36,7 @@
 #include <drkonqipaths.h>
 #include <metadata.h>
 
+#include "../admission.h"
 #include "../coredump.h"
 #include "../settings.h"
 #include "../socket.h"
@@ -148,7 +159,7 @@ void writeToDisk(const QJsonObject &contextObject, const QString &drkonqiMetadat
     }
 }
 
-static bool tryDrkonqi(const Coredump &dump)
+static bool tryDrkonqi(const Coredump &dump, DumpTruckInterface::Done done)
 {
     const QString kcrashMetadataPath = Metadata::resolveKCrashMetadataPath(dump.exe, dump.bootId, dump.pid);
     // Arm removal. In all cases we'll want to remove the kcrash metadata (we possibly created expanded drkonqi metadata instead)
@@ -166,6 +177,7 @@ static bool tryDrkonqi(const Coredump &dump)
 
     QJsonObject metadata = Metadata::readFromDisk(drkonqiMetadataPath);
     if (Metadata::isPickedUp(metadata)) {
+        done();
         return true; // already handled previously
     }
     if (metadata.isEmpty()) {
@@ -196,12 +208,27 @@ static bool tryDrkonqi(const Coredump &dump)
         return false;
     }
 
-    setenv("DRKONQI_BACKEND", "COREDUMPD", 1);
-    setenv("DRKONQI_METADATA_FILE", qPrintable(drkonqiMetadataPath), 1);
+    auto environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(u"DRKONQI_BACKEND"_s, u"COREDUMPD"_s);
+    environment.insert(u"DRKONQI_METADATA_FILE"_s, drkonqiMetadataPath);
 
     // We must start drkonqi in a new slice. This launcher will want to terminate quickly and we enforce that
     // through maximum run time in the unit configuration. If drkonqi wasn't in a new slice it'd get killed with us.
-    QProcess::execute(Paths::drkonqiExe(), Metadata::metadataArguments(metadata[Metadata::KCRASH_KEY].toObject().toVariantHash()));
+    // Wait for it without blocking, a daemonized launcher may receive further dumps in the meantime.
+    auto process = new QProcess;
+    process->setProcessEnvironment(environment);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    auto finish = [process, done = DumpTruckInterface::once(std::move(done))] {
+        process->deleteLater();
+        done();
+    };
+    QObject::connect(process, &QProcess::finished, process, finish);
+    QObject::connect(process, &QProcess::errorOccurred, process, [finish](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            finish();
+        }
+    });
+    process->start(Paths::drkonqiExe(), Metadata::metadataArguments(metadata[Metadata::KCRASH_KEY].toObject().toVariantHash()));
 
     return true; // always considered handled, even if drkonqi crashes or something
 }
@@ -212,93 +239,298 @@ public:
     DrKonqiTruck() = default;
     ~DrKonqiTruck() override = default;
 
-    bool handle(const Coredump &dump) override
+    bool handle(const Coredump &dump, Done done) override
     {
-        return tryDrkonqi(dump);
+        return tryDrkonqi(dump, std::move(done));
     }
 
 private:
     Q_DISABLE_COPY_MOVE(DrKonqiTruck)
 };
 
-static void onNewDump(const Coredump &dump)
+static void onNewDump(const Coredump &dump, const DumpTruckInterface::Done &done)
 {
     static DrKonqiTruck drkonqi;
-    if (drkonqi.handle(dump)) {
+    if (drkonqi.handle(dump, done)) {
         return;
     }
 
     if (qEnvironmentVariableIntValue("KDE_COREDUMP_NOTIFY") == 1) {
         static DevNotifierTruck notifier;
-        if (notifier.handle(dump)) {
+        if (notifier.handle(dump, done)) {
             return;
         }
     }
 
     static GlobalNotifierTruck notifier;
-    if (notifier.handle(dump)) {
+    if (notifier.handle(dump, done)) {
         return;
     }
 
     qWarning() << "Nothing handled the dump :O";
+    done();
 }
 
-int main(int argc, char **argv)
+// A storm that is over only gets a notification. The crash that started it already went through DrKonqi.
+static void onStormOver(const Admission::Suppressed &storm, const DumpTruckInterface::Done &done)
 {
-    QGuiApplication app(argc, argv);
-    // Never let the launcher participate in session management. It will break things because we assume to be invoked by systemd sockets exclusively.
-    QCoreApplication::setAttribute(Qt::AA_DisableSessionManager);
-    app.setApplicationName(QStringLiteral("drkonqi-coredump-launcher"));
-    app.setOrganizationDomain(QStringLiteral("kde.org"));
+    auto fields = storm.fields;
+    // Counting the crash that was handled before the storm set in.
+    fields.insert(Coredump::keyCrashCount(), QByteArray::number(storm.count + 1));
+    const Coredump dump(fields.value(Coredump::keyCursor()), fields);
 
-    if (sd_listen_fds(false) != 1) {
-        qFatal("Not exactly one fd passed by systemd. Quel malheur!");
-        return 1;
+    if (qEnvironmentVariableIntValue("KDE_COREDUMP_NOTIFY") == 1) {
+        static DevNotifierTruck notifier;
+        if (notifier.handle(dump, done)) {
+            return;
+        }
     }
 
-    // Reading is very awkward and I'm not even sure why.
-    // It seems like QLocalSocket doesn't manage to model stream sockets properly or at least not SOCK_SEQPACKET.
-    // The socket on our end never notices that the remote has closed and even terminated already.
-    //
-    // Since we don't really need to do anything fancy we'll simply poll on our own instead of relying on QLS.
+    static GlobalNotifierTruck notifier;
+    if (notifier.handle(dump, done)) {
+        return;
+    }
 
-    QByteArray json;
-    QByteArray segment;
-    segment.resize(Socket::DatagramSize);
-    while (true) {
-        struct pollfd poll {
-        };
-        poll.fd = SD_LISTEN_FDS_START;
-        poll.events = POLLIN;
-        struct timespec time {
-        };
-        time.tv_nsec = (2500ns).count();
-        ppoll(&poll, 1, &time, nullptr);
+    qDebug() << "Nothing reported the crash storm of" << dump.exe;
+    done();
+}
 
-        if (poll.revents & POLLERR) {
-            qFatal("Socket had an error");
-            break;
+// When something crash-loops only some of its crashes get handled, the rest are counted. An admitted dump stands for
+// the crashes held back before it, the count ends up in the journal data the trucks pass on (e.g. to DrKonqi).
+// Cheap enough to run before anything else is set up.
+[[nodiscard]] static Admission::Decision admitDump(Coredump &dump)
+{
+    // Picked up crashes are old news, they don't take part in the rate limiting.
+    if (!dump.m_rawData.value(Coredump::keyPickup()).isEmpty()) {
+        return {};
+    }
+
+    auto decision = Admission().admit(dump);
+    if (decision.admitted && decision.stormCount > 0) {
+        dump.crashCount = decision.stormCount + 1;
+        dump.m_rawData.insert(Coredump::keyCrashCount(), QByteArray::number(dump.crashCount));
+    } else if (!decision.admitted) {
+        qDebug() << "Not handling crash of" << dump.exe << "it has been crashing too often";
+    }
+    return decision;
+}
+
+// Hands the dump and the storms that are over to the trucks, done runs once they are finished with them.
+static void truckDump(const Coredump &dump, const Admission::Decision &decision, DumpTruckInterface::Done done)
+{
+    // The lambdas handed to the trucks are only here to scope the locker.
+    const auto locker = DumpTruckInterface::locker(std::move(done));
+    for (const auto &storm : decision.suppressed) {
+        onStormOver(storm, [locker] {});
+    }
+    if (decision.admitted) {
+        onNewDump(dump, [locker] {});
+    }
+}
+
+static void expireStorms(DumpTruckInterface::Done done)
+{
+    const auto locker = DumpTruckInterface::locker(std::move(done));
+    for (const auto &storm : Admission().expire()) {
+        onStormOver(storm, [locker] {});
+    }
+}
+
+[[nodiscard]] static std::chrono::milliseconds timeUntil(std::chrono::system_clock::time_point time)
+{
+    return std::max(std::chrono::duration_cast<std::chrono::milliseconds>(time - std::chrono::system_clock::now()), 0ms);
+}
+
+[[nodiscard]] static std::unique_ptr<Coredump> decodeDump(const Socket::Message &message)
+{
+    switch (message.format) {
+    case Socket::Format::Records: {
+        auto dump = Coredump::fromRecords(message.payload);
+        if (!dump) {
+            qWarning() << "Failed to decode dump records";
+        }
+        return dump;
+    }
+    case Socket::Format::Json: {
+        // Compatibility with processors that predate the record format.
+        QJsonParseError error{};
+        const QJsonDocument document = QJsonDocument::fromJson(message.payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qWarning() << "json parse error" << error.errorString();
+            return nullptr;
+        }
+        return std::make_unique<Coredump>(document);
+    }
+    }
+    qWarning() << "Unknown dump format" << static_cast<int>(message.format);
+    return nullptr;
+}
+
+// Long-lived mode: systemd passes the listening socket (Accept=no) and we accept the connections ourselves. The trucks,
+// KService and the notification plumbing stay warm between dumps.
+// Nothing here blocks. Dumps are received as their data arrives and then queued for the trucks. Only so many dumps are
+// handled at a time, much like MaxConnections limits the launchers started per connection.
+// Exits after being idle for a while, systemd starts us again when the next dump comes in.
+class LauncherDaemon : public QObject
+{
+public:
+    static constexpr int MaxTrucking = 16;
+
+    LauncherDaemon(int listenFd, std::chrono::milliseconds idleTimeout)
+        : m_listenFd(listenFd)
+        , m_notifier(listenFd, QSocketNotifier::Read)
+    {
+        if (const int flags = fcntl(m_listenFd, F_GETFL); flags >= 0) {
+            fcntl(m_listenFd, F_SETFL, flags | O_NONBLOCK);
+        }
+        m_idleTimer.setInterval(idleTimeout);
+        m_idleTimer.setSingleShot(true);
+        connect(&m_idleTimer, &QTimer::timeout, qApp, &QCoreApplication::quit);
+        connect(&m_notifier, &QSocketNotifier::activated, this, &LauncherDaemon::accept);
+        m_idleTimer.start();
+    }
+
+private:
+    // A connection from the processor. Reads whatever is available whenever the socket is readable.
+    struct Connection {
+        explicit Connection(int fd)
+            : fd(fd)
+            , notifier(fd, QSocketNotifier::Read)
+        {
+        }
+        ~Connection()
+        {
+            ::close(fd);
+        }
+        const int fd;
+        QSocketNotifier notifier;
+        QTimer timeout;
+        Socket::Receiver receiver;
+        Q_DISABLE_COPY_MOVE(Connection)
+    };
+
+    void accept()
+    {
+        while (true) {
+            const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    qWarning() << "Failed to accept connection:" << strerror(errno);
+                }
+                return;
+            }
+
+            hold();
+            auto connection = std::make_shared<Connection>(fd);
+            connection->timeout.setInterval(1min);
+            connection->timeout.setSingleShot(true);
+            connect(&connection->notifier, &QSocketNotifier::activated, this, [this, connection = connection.get()] {
+                receive(connection);
+            });
+            connect(&connection->timeout, &QTimer::timeout, this, [this, connection = connection.get()] {
+                qWarning() << "Timed out receiving dump";
+                drop(connection);
+            });
+            connection->timeout.start();
+            m_connections.push_back(std::move(connection));
         }
+    }
 
-        if (poll.revents & POLLNVAL) {
-            qFatal("Socket was invalid");
+    void receive(Connection *connection)
+    {
+        switch (connection->receiver.read(connection->fd)) {
+        case Socket::Receiver::State::Pending:
+            return;
+        case Socket::Receiver::State::Failed:
+            qWarning() << "Failed to receive dump";
+            drop(connection);
+            return;
+        case Socket::Receiver::State::Finished:
             break;
         }
 
-        if (poll.revents & POLLIN) {
-            const size_t size = read(poll.fd, segment.data(), segment.size());
-            if (size == 0 && poll.revents & POLLHUP) {
-                break; // zero read + POLLHUP = EOS says the manpage
+        auto dump = decodeDump(connection->receiver.take());
+        drop(connection);
+        if (!dump) {
+            return;
+        }
+        hold(); // for the queued dump, the connection's hold went away with the connection
+        m_queue.push_back(std::move(dump));
+        dispatch();
+    }
+
+    // Called from within the connection's own signals, so it may only go away once those have returned.
+    void drop(Connection *connection)
+    {
+        const auto it = std::ranges::find_if(m_connections, [connection](const auto &candidate) {
+            return candidate.get() == connection;
+        });
+        if (it == m_connections.end()) {
+            return;
+        }
+        connection->notifier.setEnabled(false);
+        connection->timeout.stop();
+        QTimer::singleShot(0, this, [connection = std::move(*it)] {});
+        m_connections.erase(it);
+        release();
+    }
+
+    void dispatch()
+    {
+        while (m_trucking < MaxTrucking && !m_queue.empty()) {
+            const auto dump = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_trucking;
+            const auto decision = admitDump(*dump);
+            truckDump(*dump, decision, [this] {
+                --m_trucking;
+                release();
+                // Not from within whatever truck just finished.
+                QTimer::singleShot(0, this, &LauncherDaemon::dispatch);
+            });
+            if (const auto expiry = decision.expiry; expiry.has_value()) {
+                // We are around anyway, stay until the storm is over so it gets reported even when nothing crashes
+                // anymore.
+                hold();
+                QTimer::singleShot(timeUntil(expiry.value()), this, [this] {
+                    expireStorms([this] {
+                        release();
+                    });
+                });
             }
-            json.append(segment.data(), size);
         }
     }
-    close(SD_LISTEN_FDS_START);
 
-    QJsonParseError error{};
-    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
-    if (error.error != QJsonParseError::NoError) {
-        qWarning() << "json parse error" << error.errorString();
+    void hold()
+    {
+        m_idleTimer.stop();
+        ++m_active;
+    }
+
+    void release()
+    {
+        if (--m_active == 0) {
+            m_idleTimer.start();
+        }
+    }
+
+    const int m_listenFd;
+    QSocketNotifier m_notifier;
+    QTimer m_idleTimer;
+    int m_active = 0;
+    std::vector<std::shared_ptr<Connection>> m_connections;
+    std::deque<std::unique_ptr<Coredump>> m_queue;
+    int m_trucking = 0;
+    Q_DISABLE_COPY_MOVE(LauncherDaemon)
+};
+
+int main(int argc, char **argv)
+{
+    if (sd_listen_fds(false) != 1) {
+        qFatal("Not exactly one fd passed by systemd. Quel malheur!");
         return 1;
     }
 
@@ -310,7 +542,62 @@ int main(int argc, char **argv)
     unsetenv("LISTEN_PID");
     unsetenv("MANAGERPID");
 
-    onNewDump(Coredump(document));
+    const bool listening = sd_is_socket(SD_LISTEN_FDS_START, AF_UNIX, SOCK_SEQPACKET, 1 /* listening */) > 0;
+
+    // One launcher per dump: receive and admit the dump before setting up the application. During a crash storm most
+    // launchers have nothing to do and should be gone again without ever having talked to the display server.
+    std::unique_ptr<Coredump> dump;
+    Admission::Decision decision;
+    if (!listening) {
+        // The processor sends the dump and then closes the connection. Simply sleep in recv until that happens.
+        // QLocalSocket doesn't model SOCK_SEQPACKET properly and never notices the remote having closed, so don't use it.
+        const auto message = Socket::receive(SD_LISTEN_FDS_START, 1min);
+        close(SD_LISTEN_FDS_START);
+        if (!message.has_value()) {
+            qWarning() << "Failed to receive dump";
+            return 1;
+        }
+
+        dump = decodeDump(message.value());
+        if (!dump) {
+            return 1;
+        }
+
+        // Storms that are over get reported by whichever launcher checks next. We don't stick around for the storm we
+        // may be part of, holding on to a launcher per storm is what admission is meant to avoid.
+        decision = admitDump(*dump);
+        if (!decision.admitted && decision.suppressed.isEmpty()) {
+            return 0;
+        }
+    }
+
+    QGuiApplication app(argc, argv);
+    // Never let the launcher participate in session management. It will break things because we assume to be invoked by systemd sockets exclusively.
+    QCoreApplication::setAttribute(Qt::AA_DisableSessionManager);
+    app.setApplicationName(QStringLiteral("drkonqi-coredump-launcher"));
+    app.setOrganizationDomain(QStringLiteral("kde.org"));
+
+    // This binary is for internal use and intentionally has no i18n!
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption idleOption("idle-exit"_L1, "Minutes to stay around without dumps when started with a listening socket."_L1, "minutes"_L1, "10"_L1);
+    parser.addOption(idleOption);
+    parser.process(app);
+
+    // Library internals must not be able to quit us through the application quit lock. We quit once our dumps are done
+    // with, respectively when the idle timer says so.
+    app.setQuitLockEnabled(false);
+
+    if (listening) {
+        LauncherDaemon daemon(SD_LISTEN_FDS_START, std::chrono::minutes(std::max(parser.value(idleOption).toInt(), 1)));
+        return app.exec();
+    }
+
+    bool done = false;
+    truckDump(*dump, decision, [&done] {
+        done = true;
+        QCoreApplication::quit();
+    });
 
-    return 0;
+    return done ? 0 : app.exec();
 }
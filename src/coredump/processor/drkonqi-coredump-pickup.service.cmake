@@ -4,9 +4,9 @@
 [Unit]
 Description=Consume pending crashes using DrKonqi
 PartOf=graphical-session.target
-Requires=drkonqi-coredump-launcher.socket
+Requires=@LAUNCHER_SOCKET@
 After=plasma-core.target
-After=drkonqi-coredump-launcher.socket
+After=@LAUNCHER_SOCKET@
 ConditionUser=!@system
 
 [Service]
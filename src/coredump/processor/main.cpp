@@ -9,8 +9,6 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QFile>
-#include <QJsonDocument>
-#include <QLocalSocket>
 #include <QScopeGuard>
 #include <QVariant>
 
@@ -65,6 +63,13 @@ int main(int argc, char **argv)
     if (!uid.isEmpty()) {
         watcher.addMatch(u"COREDUMP_UID=%1"_s.arg(uid));
     }
+    if (!instance.isEmpty()) {
+        // We get started alongside the systemd-coredump@ instance, so its entry is either very recent or yet to be
+        // written. Don't walk the entire journal of the boot to find it, that grows with uptime.
+        // The margin is the same as our maximum run time, we'd not find the entry past that either way.
+        constexpr auto margin = 5min;
+        watcher.setSince(std::chrono::system_clock::now() - margin);
+    }
     QObject::connect(&watcher, &CoredumpWatcher::newDump, &app, [&watcher, pickup](const Coredump &dump) {
         if (pickup && !QFile::exists(dump.filename)) {
             // We only ignore missing cores when picking up old crashes. When dealing with new ones we may still wish
@@ -111,34 +116,17 @@ int main(int argc, char **argv)
             return;
         }
 
-        // Convert the raw data to JSON and send that over the socket. This means
-        // the client side doesn't need to talk to journald again. A tad more efficient,
-        // and it makes nary a difference in code.
-        QVariantMap variantMap;
+        // Send the raw data over the socket. This means the client side doesn't need to talk to journald again.
+        // A tad more efficient, and it makes nary a difference in code.
+        auto data = dump.m_rawData;
         if (pickup) { // forward this into the launcher so it can choose to not have dump trucks handle dumps without metadata
-            variantMap.insert(QString::fromUtf8(Coredump::keyPickup()), "TRUE"_ba);
-        }
-        for (auto it = dump.m_rawData.cbegin(); it != dump.m_rawData.cend(); ++it) {
-            variantMap.insert(QString::fromUtf8(it.key()), it.value());
+            data.insert(Coredump::keyPickup(), "TRUE"_ba);
         }
-
-        QLocalSocket s;
-        s.setSocketDescriptor(fd, QLocalSocket::ConnectedState, QLocalSocket::WriteOnly);
-        QByteArray data = QJsonDocument::fromVariant(variantMap).toJson();
-        while (!data.isEmpty()) {
-            // NB: we need to constrain the segment size to not run into QLocalSocket::DatagramTooLargeError
-            const qint64 written = s.write(data.constData(), std::min<int>(data.size(), Socket::DatagramSize));
-            if (written > 0) {
-                data = data.mid(written);
-                s.waitForBytesWritten();
-            } else if (s.state() != QLocalSocket::ConnectedState) {
-                qWarning() << "socket state unexpectedly" << s.state() << "aborting crash processing";
-                qApp->quit();
-                return;
-            }
+        if (!Socket::send(fd, Socket::Format::Records, Coredump::toRecords(data))) {
+            qWarning() << "Failed to send dump to launcher, aborting crash processing";
+            qApp->quit();
+            return;
         }
-        s.flush();
-        s.waitForBytesWritten();
 
         Q_EMIT watcher.finished();
         return;
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "serviceindex.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KApplicationTrader>
+#include <KShell>
+#include <KSycoca>
+
+#include "decode.h"
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr quint32 MAGIC = 0x444b5349; // DKSI
+// Bump whenever the way the index is derived changes.
+constexpr quint32 VERSION = 1;
+
+[[nodiscard]] QString sycocaStamp()
+{
+    KSycoca::self()->ensureCacheValid();
+    const QFileInfo info(KSycoca::absoluteFilePath());
+    return info.filePath() + u':' + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+[[nodiscard]] QString executableName(const KService::Ptr &service)
+{
+    const auto arguments = KShell::splitArgs(service->exec());
+    if (arguments.isEmpty()) {
+        return {};
+    }
+    return QFileInfo(arguments.constFirst()).fileName();
+}
+} // namespace
+
+ServiceIndex::ServiceIndex()
+{
+    QObject::connect(KSycoca::self(), &KSycoca::databaseChanged, &m_context, [this] {
+        m_index.reset();
+    });
+}
+
+ServiceIndex *ServiceIndex::self()
+{
+    static ServiceIndex index;
+    return &index;
+}
+
+QString ServiceIndex::path()
+{
+    // Generic so the launcher and the GUI share the same index.
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + u"/drkonqi/service.index"_s;
+}
+
+KService::Ptr ServiceIndex::serviceForExecutable(const QString &executable)
+{
+    const auto storageId = index().executables.value(executable);
+    if (storageId.isEmpty()) {
+        return {};
+    }
+    return KService::serviceByStorageId(storageId);
+}
+
+KService::Ptr ServiceIndex::serviceForUnitName(const QString &unitName)
+{
+    const auto serviceName = unitNameToServiceName(unitName);
+    if (serviceName.isEmpty()) {
+        return {};
+    }
+
+    const auto &menuIds = index().menuIds;
+    if (auto it = menuIds.constFind(serviceName.toString() + ".desktop"_L1); it != menuIds.cend()) {
+        if (it->isEmpty()) {
+            // Terminals most of the time host applications in their own cgroup, making it impossible to detect the
+            // correct service, if any.
+            return {};
+        }
+        return KService::serviceByStorageId(*it);
+    }
+    // Autostart files are not part of the sycoca, look them up directly. Only happens for autostart units.
+    if (unitName.endsWith("@autostart.service"_L1)) {
+        if (auto file = QStandardPaths::locate(QStandardPaths::GenericConfigLocation, u"autostart/%1.desktop"_s.arg(serviceName)); !file.isEmpty()) {
+            if (auto service = new KService(file); service->isValid()) {
+                return KService::Ptr(service);
+            }
+        }
+    }
+
+    return {};
+}
+
+const ServiceIndex::Index &ServiceIndex::index()
+{
+    if (!m_index) {
+        const auto stamp = sycocaStamp();
+        m_index = load(path(), stamp);
+        if (!m_index) {
+            m_index = build(stamp);
+            save(path(), *m_index);
+        }
+    }
+    return *m_index;
+}
+
+std::optional<ServiceIndex::Index> ServiceIndex::load(const QString &path, const QString &stamp)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    Index index;
+    stream >> magic >> version >> index.stamp;
+    if (magic != MAGIC || version != VERSION || index.stamp != stamp) {
+        qDebug() << "Ignoring outdated service index" << path << version << index.stamp;
+        return std::nullopt;
+    }
+    stream >> index.executables >> index.menuIds;
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring corrupt service index" << path;
+        return std::nullopt;
+    }
+    return index;
+}
+
+ServiceIndex::Index ServiceIndex::build(const QString &stamp)
+{
+    Index index{.stamp = stamp, .executables = {}, .menuIds = {}};
+
+    // Several applications may share an executable (e.g. with different arguments), the first one wins.
+    const auto applications = KApplicationTrader::query([](const KService::Ptr &) {
+        return true;
+    });
+    for (const auto &service : applications) {
+        if (const auto executable = executableName(service); !executable.isEmpty() && !index.executables.contains(executable)) {
+            index.executables.insert(executable, service->storageId());
+        }
+    }
+
+    // Units may also belong to applications that are not displayed (e.g. NoDisplay=true), consider them all.
+    const auto services = KService::allServices();
+    for (const auto &service : services) {
+        if (!service->isApplication() || service->menuId().isEmpty()) {
+            continue;
+        }
+        const bool terminal = service->categories().contains("TerminalEmulator"_L1);
+        index.menuIds.insert(service->menuId(), terminal ? QString() : service->storageId());
+    }
+
+    return index;
+}
+
+bool ServiceIndex::save(const QString &path, const Index &index)
+{
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "Failed to open service index for writing" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << MAGIC << VERSION << index.stamp << index.executables << index.menuIds;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write service index" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
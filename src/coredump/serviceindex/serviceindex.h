@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <optional>
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+#include <KService>
+
+// Maps the things a crash tells us about its origin (executable, systemd unit) to the application service.
+// Built once from the sycoca and cached on disk, so resolving is a hash look-up rather than a walk over all services.
+// Rebuilt whenever the sycoca changes. Main thread only, much like the sycoca itself.
+class ServiceIndex
+{
+public:
+    ServiceIndex();
+    [[nodiscard]] static ServiceIndex *self();
+    [[nodiscard]] static QString path();
+
+    // The application with the given executable basename. Null if there is none.
+    [[nodiscard]] KService::Ptr serviceForExecutable(const QString &executable);
+    // The application a systemd unit was started for. Null for non-applications and terminal emulators.
+    [[nodiscard]] KService::Ptr serviceForUnitName(const QString &unitName);
+
+private:
+    struct Index {
+        // Identifies the sycoca the index was built from.
+        QString stamp;
+        // Executable basename -> storage id
+        QHash<QString, QString> executables;
+        // Menu id -> storage id. Empty for terminal emulators.
+        QHash<QString, QString> menuIds;
+    };
+
+    const Index &index();
+    [[nodiscard]] static std::optional<Index> load(const QString &path, const QString &stamp);
+    [[nodiscard]] static Index build(const QString &stamp);
+    static bool save(const QString &path, const Index &index);
+
+    std::optional<Index> m_index;
+    // Scopes the sycoca connection to our lifetime.
+    QObject m_context;
+};
@@ -0,0 +1,136 @@
+/*
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include "socket.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <QDebug>
+
+namespace
+{
+[[nodiscard]] bool sendDatagram(int fd, const char *data, size_t size)
+{
+    while (true) {
+        const auto written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written >= 0) {
+            // SOCK_SEQPACKET is all-or-nothing
+            Q_ASSERT(static_cast<size_t>(written) == size);
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        qWarning() << "Failed to send on socket:" << strerror(errno);
+        return false;
+    }
+}
+} // namespace
+
+bool Socket::send(int fd, Format format, QByteArrayView payload)
+{
+    if (payload.size() > MaxPayloadSize) {
+        qWarning() << "Payload of" << payload.size() << "bytes is too large to send";
+        return false;
+    }
+    const Header header{.format = format, .size = static_cast<quint32>(payload.size())};
+    if (!sendDatagram(fd, reinterpret_cast<const char *>(&header), sizeof(header))) {
+        return false;
+    }
+    for (qsizetype offset = 0; offset < payload.size(); offset += DatagramSize) {
+        const auto size = std::min<qsizetype>(payload.size() - offset, DatagramSize);
+        if (!sendDatagram(fd, payload.data() + offset, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Socket::Receiver::State Socket::Receiver::read(int fd)
+{
+    while (true) {
+        // Every read must have room for a full datagram, or the remainder of the datagram gets discarded.
+        // With a header the capacity was reserved up front and this never reallocates.
+        m_payload.resize(m_used + DatagramSize);
+        const auto size = recv(fd, m_payload.data() + m_used, DatagramSize, 0);
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return State::Pending;
+            }
+            qWarning() << "Failed to receive on socket:" << strerror(errno);
+            return State::Failed;
+        }
+        if (size == 0) {
+            break; // remote closed the connection
+        }
+
+        if (m_used == 0 && !m_expectedSize.has_value() && size == sizeof(Header)) {
+            Header header;
+            std::memcpy(&header, m_payload.constData(), sizeof(header));
+            if (header.magic == Header::MAGIC) {
+                if (header.version != Header::VERSION) {
+                    qWarning() << "Unsupported protocol version" << header.version;
+                    return State::Failed;
+                }
+                if (header.size > MaxPayloadSize) {
+                    qWarning() << "Refusing payload of" << header.size << "bytes";
+                    return State::Failed;
+                }
+                m_expectedSize = header.size;
+                m_format = header.format;
+                m_payload.reserve(header.size + DatagramSize);
+                continue;
+            }
+        }
+        m_used += size;
+        if (m_used > m_expectedSize.value_or(MaxPayloadSize)) {
+            qWarning() << "Received more than" << m_expectedSize.value_or(MaxPayloadSize) << "bytes";
+            return State::Failed;
+        }
+    }
+    m_payload.truncate(m_used);
+
+    if (m_expectedSize.has_value() && m_expectedSize.value() != m_used) {
+        qWarning() << "Received" << m_used << "bytes but expected" << m_expectedSize.value();
+        return State::Failed;
+    }
+    return State::Finished;
+}
+
+Socket::Message Socket::Receiver::take()
+{
+    return Message{.format = m_format, .payload = std::move(m_payload)};
+}
+
+std::optional<Socket::Message> Socket::receive(int fd, std::chrono::seconds timeout)
+{
+    // We sleep in recv until data arrives or the remote hangs up. Make sure we actually can.
+    if (const int flags = fcntl(fd, F_GETFL); flags >= 0 && (flags & O_NONBLOCK)) {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    const timeval time{.tv_sec = static_cast<time_t>(timeout.count()), .tv_usec = 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(time));
+
+    Receiver receiver;
+    switch (receiver.read(fd)) {
+    case Receiver::State::Finished:
+        return receiver.take();
+    case Receiver::State::Pending: // only happens when the timeout was hit
+        qWarning() << "Timed out receiving on socket";
+        return std::nullopt;
+    case Receiver::State::Failed:
+        return std::nullopt;
+    }
+    Q_UNREACHABLE();
+}
@@ -5,7 +5,69 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <optional>
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+// SOCK_SEQPACKET transport between the coredump processor and launcher.
+// The sender leads with a Header datagram, followed by the payload split into datagrams of at most DatagramSize.
+// The end of the payload is signaled by closing the connection.
 namespace Socket
 {
 constexpr int DatagramSize = 8192;
+// Payloads are the metadata of a crash, the core itself never goes over the socket. Anything bigger than this is
+// rejected rather than allocated for, the size in the header comes from the remote.
+constexpr quint32 MaxPayloadSize = 16 * 1024 * 1024;
+
+enum class Format : quint16 {
+    Json = 0, // legacy; also what senders without header send
+    Records = 1, // Coredump::toRecords
+};
+
+struct Header {
+    static constexpr std::array<char, 4> MAGIC{'D', 'K', 'Q', 'C'};
+    static constexpr quint16 VERSION = 1;
+    std::array<char, 4> magic = MAGIC;
+    quint16 version = VERSION;
+    Format format = Format::Records;
+    quint32 size = 0; // of the payload following the header
+};
+static_assert(sizeof(Header) == 12);
+
+struct Message {
+    Format format = Format::Json;
+    QByteArray payload;
+};
+
+// Assembles a message from whatever the socket has to offer at the moment. Meant for non-blocking sockets, call
+// read() whenever the socket is readable until the message is no longer Pending.
+// Senders that don't send a header are still supported (as Format::Json), they just don't get the allocation
+// optimization.
+class Receiver
+{
+public:
+    enum class State {
+        Pending, // the remote hasn't closed the connection yet
+        Finished,
+        Failed,
+    };
+
+    [[nodiscard]] State read(int fd);
+    // Only valid once Finished.
+    [[nodiscard]] Message take();
+
+private:
+    QByteArray m_payload;
+    qsizetype m_used = 0;
+    std::optional<quint32> m_expectedSize;
+    Format m_format = Format::Json;
+};
+
+// Sends header and payload. Blocks until everything is written.
+[[nodiscard]] bool send(int fd, Format format, QByteArrayView payload);
+// Blocks until the remote closes the connection or the timeout is hit.
+[[nodiscard]] std::optional<Message> receive(int fd, std::chrono::seconds timeout);
 } // namespace Socket
@@ -18,6 +18,7 @@
 #include <QDBusReply>
 #include <QDebug>
 #include <QDirIterator>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QProcess>
@@ -38,7 +39,10 @@
 #include "drkonqi.h"
 #include "drkonqi_debug.h"
 #include "linuxprocmapsparser.h"
+#include "systemd/memoryfence.h"
+#include "systemd/memorypressure.h"
 #include <coredumpexcavator.h>
+#include <coremodules.h>
 
 using namespace std::chrono_literals;
 using namespace Qt::StringLiterals;
@@ -240,6 +244,10 @@ CrashedApplication *CoredumpBackend::constructCrashedApplication()
         for (const auto &[key, value] : details.asKeyValueRange()) {
             hash.insert(key, value.toString());
         }
+        // The launcher may have held back earlier crashes of the same executable, this one stands for all of them.
+        if (const auto crashCount = m_journalEntry.value(Coredump::keyCrashCount()).toInt(); crashCount > 1) {
+            hash.insert(u"drkonqi-crash-count"_s, QString::number(crashCount));
+        }
         return hash;
     }();
     m_crashedApplication->m_gpu = m_metadata[u"kcrash-gpu"_s].toObject().toVariantHash();
@@ -265,17 +273,33 @@ DebuggerManager *CoredumpBackend::constructDebuggerManager()
 void CoredumpBackend::prepareForDebugger()
 {
     if (m_excavator) {
-        m_excavator->excavateFrom(QString::fromUtf8(m_journalEntry["COREDUMP_FILENAME"]));
+        m_excavator->excavateFrom(QString::fromUtf8(m_journalEntry["COREDUMP_FILENAME"]), m_journalEntry[Coredump::keyCursor()]);
         return;
     }
 
     m_excavator = std::make_unique<AutomaticCoredumpExcavator>();
+    m_excavator->setFreeRAM(MemoryFence::freeRAM());
+    // The core may have been placed in memory. Should memory get tight give it back, a retried debugger then uses
+    // the disk copy.
+    connect(MemoryPressure::instance(), &MemoryPressure::levelChanged, m_excavator.get(), [this] {
+        if (MemoryPressure::instance()->level() == MemoryPressure::Level::High) {
+            m_excavator->moveToDisk();
+        }
+    });
     connect(m_excavator.get(), &AutomaticCoredumpExcavator::failed, this, &CoredumpBackend::failedToPrepare);
+    connect(m_excavator.get(), &AutomaticCoredumpExcavator::excavating, this, [this](const QString &corePath) {
+        // The path is final before the core is there. The debugger can get its startup out of the way meanwhile.
+        m_crashedApplication->m_coreFile = corePath;
+        m_crashedApplication->m_moduleTableFile = CoreModules::tablePath(corePath);
+        Q_EMIT pipelinedForDebugger();
+    });
     connect(m_excavator.get(), &AutomaticCoredumpExcavator::excavated, this, [this](const QString &corePath) {
         m_crashedApplication->m_coreFile = corePath;
+        const auto tablePath = CoreModules::tablePath(corePath);
+        m_crashedApplication->m_moduleTableFile = QFileInfo::exists(tablePath) ? tablePath : QString();
         Q_EMIT preparedForDebugger();
     });
-    m_excavator->excavateFrom(QString::fromUtf8(m_journalEntry["COREDUMP_FILENAME"]));
+    m_excavator->excavateFrom(QString::fromUtf8(m_journalEntry["COREDUMP_FILENAME"]), m_journalEntry[Coredump::keyCursor()]);
 }
 
 std::optional<QByteArray> CoredumpBackend::bootId() const
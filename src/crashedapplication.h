@@ -135,6 +135,8 @@ protected:
 public:
     // Only set for the 'coredumpd' backend. Path to on-disk core dump.
     QString m_coreFile;
+    // Also only set for coredumpd backend. Module table of the core (JSON), when one could be built.
+    QString m_moduleTableFile;
     // Also only set for coredumpd backend. A bunch of log entries from journal.
     QList<EntriesHash> m_logs;
     QHash<QString, QString> m_tags;
@@ -6,39 +6,63 @@ import sys
 
 sys.path.append(f'{os.path.dirname(os.path.dirname(os.path.abspath(__file__)))}/')
 
-# Initialize sentry reports for exceptions in this script
-# NOTE: this happens before other imports so we get reports when we have systems with missing deps
-try:
-    import sentry_sdk
-    sentry_sdk.init(
-        dsn="https://d6d53bb0121041dd97f59e29051a1781@crash-reports.kde.org/13",
-        traces_sample_rate=1.0,
-        release="drkonqi@" + os.getenv('DRKONQI_VERSION'),
-        dist=os.getenv('DRKONQI_DISTRIBUTION'),
-        ignore_errors=[KeyboardInterrupt],
-        # Shutdown performance doesn't matter all that much, give us ample time to send a possible report instead.
-        shutdown_timeout=30,
-    )
-except ImportError:
-    print("python sentry-sdk not installed :(")
-
 os.environ['LC_ALL'] = 'C.UTF-8'
 
-import gdb
-from gdb.FrameDecorator import FrameDecorator
-
-from datetime import datetime, timezone
-import uuid
-import json
-import subprocess
-import signal
-import re
-import binascii
-import platform
-import multiprocessing
-from pathlib import Path
-import psutil
-import traceback
+class Sentry:
+    # Reports exceptions in this script. sentry_sdk is slow to import and only needed once something went wrong,
+    # so breadcrumbs are collected locally and only handed to the sdk when there is something to report.
+    breadcrumbs = []
+    initialized = False
+
+    @staticmethod
+    def add_breadcrumb(**kwargs):
+        Sentry.breadcrumbs.append(kwargs)
+
+    @staticmethod
+    def capture_exception(exception):
+        try:
+            import sentry_sdk
+        except ImportError:
+            print("python sentry-sdk not installed :(")
+            return
+        if not Sentry.initialized:
+            Sentry.initialized = True
+            Sentry.init(sentry_sdk)
+        for breadcrumb in Sentry.breadcrumbs:
+            sentry_sdk.add_breadcrumb(**breadcrumb)
+        Sentry.breadcrumbs.clear()
+        sentry_sdk.capture_exception(exception)
+
+    @staticmethod
+    def init(sentry_sdk):
+        sentry_sdk.init(
+            dsn="https://d6d53bb0121041dd97f59e29051a1781@crash-reports.kde.org/13",
+            traces_sample_rate=1.0,
+            release="drkonqi@" + os.getenv('DRKONQI_VERSION'),
+            dist=os.getenv('DRKONQI_DISTRIBUTION'),
+            ignore_errors=[KeyboardInterrupt],
+            # Shutdown performance doesn't matter all that much, give us ample time to send a possible report instead.
+            shutdown_timeout=30,
+        )
+
+# Systems with missing dependencies are a prime source of preamble failures. Report them, but only pay for
+# sentry_sdk when something is actually missing.
+try:
+    import gdb
+    from gdb.FrameDecorator import FrameDecorator
+
+    # NOTE: keep module level imports cheap! gdb sources this on every trace and we may well bail out before ever
+    # needing anything heavyweight. psutil, uuid, datetime, subprocess and sentry_sdk get imported where they are used.
+    import json
+    import signal
+    import re
+    import binascii
+    import itertools
+    from pathlib import Path
+    import traceback
+except ImportError as e:
+    Sentry.capture_exception(e)
+    raise
 
 crashed_thread = None
 core_images = []
@@ -109,36 +133,119 @@ class SentryVariables:
 
         return ret
 
+class FrameCapture:
+    # Everything a frame needs (function, source location, solib) is looked up in one go and memoized per pc.
+    # Symbol lookups only depend on the pc, so frames shared between threads (event loops, lock waits, ...) and
+    # between the thread sampling and the sentry payload needn't go through the gdb bridge again.
+    # Loading symbols changes the answers, so the caches are dropped whenever that happens.
+    by_pc = {} # (pc, frame type) -> (function, filename, line, package, at statement start)
+    by_thread = {} # ptid -> [SentryFrame]; only valid until the next symbol load
+
+    def invalidate():
+        FrameCapture.by_pc.clear()
+        FrameCapture.by_thread.clear()
+
+    def lookup(gdb_frame, pc, frame_type):
+        # Inline frames share the pc of their outer frame but have their own function. Don't cache them.
+        key = (pc, frame_type)
+        if frame_type != gdb.INLINE_FRAME and key in FrameCapture.by_pc:
+            return FrameCapture.by_pc[key]
+
+        sal = gdb_frame.find_sal()
+        # Not fullname(), that is wherever the source happens to be on this system (e.g. the user's home or the
+        # debuginfod cache) and has no business in a report.
+        filename = sal.symtab.filename if (sal and sal.symtab) else None
+        line = sal.line if sal else -1
+        # bt leaves out the address when the pc is right at the start of a statement
+        at_statement = bool(sal and sal.symtab and sal.pc == pc)
+        function = gdb_frame.name() or gdb_frame.function() or None
+        package = gdb.solib_name(pc)
+        if package:
+            # NOTE: realpath because neon's gdb is confused over UsrMerge symlinking of /lib to /usr/lib messing up
+            # path consistency (mapping data and by extension SentryImage instances use the real path already though
+            package = os.path.realpath(package)
+
+        info = (function, filename, line, package, at_statement)
+        if frame_type != gdb.INLINE_FRAME:
+            FrameCapture.by_pc[key] = info
+        return info
+
+    def arguments(gdb_frame):
+        # Rendered like gdb's bt does with the default `print frame-arguments scalars`.
+        try:
+            block = gdb_frame.block()
+        except RuntimeError: # no debug info
+            return ''
+        while block and not block.function:
+            block = block.superblock
+        if not block:
+            return ''
+
+        args = []
+        for symbol in block:
+            if not symbol.is_argument:
+                continue
+            try:
+                value = symbol.value(gdb_frame)
+                value_type = value.type.strip_typedefs()
+                if value_type.code in (gdb.TYPE_CODE_REF, gdb.TYPE_CODE_RVALUE_REF):
+                    value_type = value_type.target().strip_typedefs()
+                if value_type.code in (gdb.TYPE_CODE_STRUCT, gdb.TYPE_CODE_UNION, gdb.TYPE_CODE_ARRAY):
+                    text = '...'
+                else:
+                    text = value.format_string()
+            except (gdb.error, RuntimeError) as e:
+                text = f'<error reading variable: {e}>'
+            args.append(f'{symbol.name}={text}')
+        return ', '.join(args)
+
+    def frames(thread, limit=None):
+        # Captures the frames of the (selected!) thread in a single traversal. limit=None means all frames.
+        captured = FrameCapture.by_thread.get(thread.ptid)
+        if captured is not None:
+            frames, complete = captured
+            if complete or (limit is not None and len(frames) >= limit):
+                return frames[:limit]
+
+        frames = [ SentryFrame(frame) for frame in itertools.islice(gdb.FrameIterator.FrameIterator(gdb.newest_frame()), limit) ]
+        complete = limit is None or len(frames) < limit
+        FrameCapture.by_thread[thread.ptid] = (frames, complete)
+        return list(frames) # callers may reorder their copy
+
 class SentryFrame:
     def __init__(self, gdb_frame):
         self.frame = gdb_frame
-        self.sal = gdb_frame.find_sal()
+        self.pc = gdb_frame.pc()
+        self.frame_type = gdb_frame.type()
+        self.function_name, self.file, self.line, self.solib, self.at_statement = FrameCapture.lookup(gdb_frame, self.pc, self.frame_type)
+        self.args = None # only the text trace needs them, see arguments()
 
     def type(self):
-        return self.frame.type()
+        return self.frame_type
 
     def filename(self):
-        return self.sal.symtab.fullname() if (self.sal and self.sal.symtab) else None
+        return self.file
 
     def lineNumber(self):
-        if self.sal.line < 0:
+        if self.line < 0:
             return None
         # NOTE "The line number of the call, starting at 1." - I'm almost sure gdb starts at 0, so add 1
-        return self.sal.line + 1
+        return self.line + 1
 
     def function(self):
-        return self.frame.name() or self.frame.function() or None
+        return self.function_name
 
     def package(self):
-        name = gdb.solib_name(self.frame.pc())
-        if not name:
-            return name
-        # NOTE: realpath because neon's gdb is confused over UsrMerge symlinking of /lib to /usr/lib messing up
-        # path consistency (mapping data and by extension SentryImage instances use the real path already though
-        return os.path.realpath(name)
+        return self.solib
 
     def address(self):
-        return ('0x%x' % self.frame.pc())
+        return ('0x%x' % self.pc)
+
+    def arguments(self):
+        # Needs the frame's thread to be selected.
+        if self.args is None:
+            self.args = FrameCapture.arguments(self.frame)
+        return self.args
 
     def to_dict(self, with_vars):
         data = {
@@ -202,24 +309,69 @@ class LockReason:
                 return LockReason(frame, 2, 'QWaitCondition')
         return None
 
+class ThreadSampling:
+    # Processes with thousands of threads take minutes and gigabytes to unwind. Past the threshold we only fully
+    # unwind the interesting threads (crashing, main, waiting on a lock) and give the rest a summary of their top frames.
+    # Both the sentry payload and the text trace use this same policy.
+    interesting = {} # ptid -> bool; memoized so the text trace needn't walk the threads again
+
+    def threshold():
+        return int(os.getenv('DRKONQI_THREAD_SAMPLING_THRESHOLD', '256'))
+
+    def frame_count():
+        return max(1, int(os.getenv('DRKONQI_THREAD_SAMPLING_FRAMES', '8')))
+
+    def active(threads):
+        threshold = ThreadSampling.threshold()
+        return threshold > 0 and len(threads) > threshold
+
+    def is_interesting(thread, crash_thread):
+        if thread.ptid in ThreadSampling.interesting:
+            return ThreadSampling.interesting[thread.ptid]
+
+        interesting = ThreadSampling._is_interesting(thread, crash_thread)
+        ThreadSampling.interesting[thread.ptid] = interesting
+        return interesting
+
+    def _is_interesting(thread, crash_thread):
+        if thread == crash_thread:
+            return True
+        if thread.ptid[1] == gdb.selected_inferior().pid: # the main thread's LWP is the pid
+            return True
+
+        # Lock waits are always at the top of the stack. Only look at as many frames as the summary would show anyway.
+        thread.switch()
+        for frame in FrameCapture.frames(thread, ThreadSampling.frame_count()):
+            if frame.function() and LockReason.make(frame):
+                return True
+        return False
+
+    def frame_limit(thread, crash_thread, threads):
+        if not ThreadSampling.active(threads) or ThreadSampling.is_interesting(thread, crash_thread):
+            return None
+        return ThreadSampling.frame_count()
+
 class SentryTrace:
     loaded_solibs = []
 
-    def __init__(self, thread, is_crashed):
+    def __init__(self, thread, is_crashed, frame_limit=None):
         thread.switch()
         self.thread = thread
         self.is_crashed = is_crashed
+        self.frame_limit = frame_limit # None means all frames
         self.lock_reasons = {}
         self.was_main_thread = False
         self.crashed = self.is_crashed # different from is_crashed (=input) this indicates if we stumbled over the kcrash handler
 
-    def load_solib(thread, cramped): # NOTE: we pull thread into scope for its diagnostic value
+    def load_solib(thread, cramped, frame_limit=None): # NOTE: we pull thread into scope for its diagnostic value
         # Lazy load solibs. This is super complicated because the gdb CLI and API don't actually give us all the control.
         # Also loading new symbols resets the trace so we need to select-frames fairly aggressively.
 
         i = -1
 
         while True:
+            if frame_limit is not None and i + 1 >= frame_limit:
+                break
             # Check if the next frame even exists
             if i >= 0:
                 gdb.execute(f'select-frame {i}')
@@ -266,13 +418,14 @@ class SentryTrace:
                 # (Re)load the symbols
                 gdb.execute(f'add-symbol-file "{solib}"')
 
-            if 'sentry_sdk' in globals():
-                sentry_sdk.add_breadcrumb(
-                    category='debug',
-                    level='debug',
-                    message=f'Loaded solib {solib}',
-                )
+            Sentry.add_breadcrumb(
+                category='debug',
+                level='debug',
+                message=f'Loaded solib {solib}',
+            )
             SentryTrace.loaded_solibs.append(solib)
+            # New symbols, previously captured frames are stale now.
+            FrameCapture.invalidate()
 
         gdb.execute('select-frame 0')
 
@@ -283,9 +436,9 @@ class SentryTrace:
         spacious_memory = os.getenv('DRKONQI_MEMORY') == 'spacious'
         # In spacious mode we load all solibs by default and don't need to do anything extra. All other modes load on-demand.
         if cramped_memory or little_memory or some_memory:
-            SentryTrace.load_solib(self.thread, cramped_memory)
+            SentryTrace.load_solib(self.thread, cramped_memory, self.frame_limit)
 
-        frames = [ SentryFrame(frame) for frame in gdb.FrameIterator.FrameIterator(gdb.newest_frame()) ]
+        frames = FrameCapture.frames(self.thread, self.frame_limit)
 
         self.lock_reasons = {}
         self.was_main_thread = False
@@ -321,9 +474,10 @@ class SentryTrace:
         return data
 
 class SentryThread:
-    def __init__(self, gdb_thread, is_crashed):
+    def __init__(self, gdb_thread, is_crashed, frame_limit=None):
         self.thread = gdb_thread
         self.is_crashed = is_crashed
+        self.frame_limit = frame_limit
         self.name = self.thread.name
 
         if self.is_crashed and (self.name is None or self.name == ''):
@@ -333,7 +487,7 @@ class SentryThread:
         # https://develop.sentry.dev/sdk/event-payloads/threads/
         # As per Sentry policy, the thread that crashed with an exception should not have a stack trace,
         #  but instead, the thread_id attribute should be set on the exception and Sentry will connect the two.
-        trace = SentryTrace(self.thread, self.is_crashed)
+        trace = SentryTrace(self.thread, self.is_crashed, self.frame_limit)
         # NB: trace.to_dict creates members as side effect, run it asap
         payload = {
             'stacktrace': trace.to_dict(),
@@ -381,6 +535,7 @@ class SentryImage:
         build_id = self.build_id()
         if not build_id:
             raise NoBuildIdException(f'Unexpectedly stumbled over an objfile ({self.file}) without build_id. Not creating payload.')
+        import uuid
         truncate_bytes = 16
         build_id = build_id + ("00" * truncate_bytes)
         return str(uuid.UUID(bytes_le=binascii.unhexlify(build_id)[:truncate_bytes]))
@@ -400,10 +555,11 @@ class SentryImage:
             'code_id': self.build_id(),
             'code_file': self.image.file,
             # 'image_vmaddr': None, # not available we'd have to read the ELF I think
-            'arch': platform.machine(),
+            'arch': os.uname().machine,
         }
 
 def get_stdout(proc, env=None):
+    import subprocess
     proc = subprocess.run(proc, stdout=subprocess.PIPE, env=env)
     if proc.returncode != 0:
         return ''
@@ -430,10 +586,34 @@ class SentryEvent:
                     return value.strip()
         return None
 
+    def system_facts(self):
+        # Gathered and cached by drkonqi (see SystemFacts) so we needn't talk to the bus here.
+        facts = os.getenv('DRKONQI_SYSTEM_FACTS')
+        if facts:
+            return json.loads(facts)
+
+        # Fallback for when drkonqi didn't have the facts ready in time.
+        facts = json.loads(get_stdout(['drkonqi-sentry-data']))
+        facts['CpuModel'] = self.cpu_model()
+        return facts
+
     def make(self, program, crash_thread):
+        from datetime import datetime, timezone
+        import uuid
+
         crash_signal = int(os.getenv('DRKONQI_SIGNAL'))
-        vm = psutil.virtual_memory()
-        boot_time = datetime.fromtimestamp(psutil.boot_time()).astimezone(timezone.utc).strftime('%Y-%m-%dT%H:%M:%S')
+        base_data = self.system_facts()
+        threads = gdb.selected_inferior().threads()
+        if 'MemorySize' in base_data and 'BootTime' in base_data:
+            memory_size = base_data['MemorySize']
+            free_memory = base_data['FreeMemory']
+            boot_time = base_data['BootTime']
+        else:
+            import psutil
+            vm = psutil.virtual_memory()
+            memory_size = vm.total
+            free_memory = vm.available
+            boot_time = datetime.fromtimestamp(psutil.boot_time()).astimezone(timezone.utc).strftime('%Y-%m-%dT%H:%M:%S')
 
         # crutch to get the build id. if we did this outside gdb I expect it'd be neater
         progfile = gdb.current_progspace().filename
@@ -442,13 +622,14 @@ class SentryEvent:
         # NOTE: this is run before the other threads because as a side effect it may load symbols that help other threads produce useful output.
         stacktrace = SentryTrace(crash_thread, True).to_dict()
 
-        base_data = json.loads(get_stdout(['drkonqi-sentry-data']))
         sentry_event = { # https://develop.sentry.dev/sdk/event-payloads/
             "debug_meta": { # https://develop.sentry.dev/sdk/event-payloads/debugmeta/
                 "images": SentryImages().to_list()
             },
             'threads':  [ # https://develop.sentry.dev/sdk/event-payloads/threads/
-                 SentryThread(thread, is_crashed=(thread == crash_thread)).to_dict() for thread in gdb.selected_inferior().threads()
+                 SentryThread(thread,
+                              is_crashed=(thread == crash_thread),
+                              frame_limit=ThreadSampling.frame_limit(thread, crash_thread, threads)).to_dict() for thread in threads
             ],
             'event_id': uuid.uuid4().hex,
             # Gets overwritten by ReportInterface with a more accurate value
@@ -466,16 +647,16 @@ class SentryEvent:
             # TODO environment entry (could be staging for beta releases?)
             'contexts': { # https://develop.sentry.dev/sdk/event-payloads/contexts/
                 'device': {
-                    'name': base_data['Hostname'],
-                    'model': self.cpu_model(),
-                    'family': base_data['Chassis'],
-                    'simulator': base_data['Virtualization'],
-                    'arch': platform.machine(),
-                    'memory_size': vm.total,
-                    'free_memory': vm.available,
+                    'name': base_data.get('Hostname'),
+                    'model': base_data.get('CpuModel'),
+                    'family': base_data.get('Chassis'),
+                    'simulator': base_data.get('Virtualization'),
+                    'arch': os.uname().machine,
+                    'memory_size': memory_size,
+                    'free_memory': free_memory,
                     'boot_time': boot_time,
-                    'timezone': base_data['Timezone'],
-                    'processor_count': multiprocessing.cpu_count()
+                    'timezone': base_data.get('Timezone'),
+                    'processor_count': os.cpu_count()
                 },
                 # 'os' gets injected on the cpp side so it is always available
             },
@@ -535,6 +716,70 @@ def print_sentry_payload(thread):
             tmpfile.write(json.dumps(payload))
             tmpfile.flush()
 
+class TextTrace:
+    # Renders the captured frames the way gdb's bt does, so the text trace needn't walk the stacks a second time.
+    # Threads already captured for the sentry payload are reused as-is.
+    # Only used when sampling threads, frame filters don't apply here.
+
+    def thread_header(thread):
+        # Like `thread apply`, which doesn't print the name. BacktraceParserGdb relies on this format!
+        target = f'LWP {thread.ptid[1]}'
+        try:
+            target = f'Thread 0x{int.from_bytes(thread.handle(), sys.byteorder):x} ({target})'
+        except Exception: # needs libthread_db and a somewhat new gdb
+            pass
+        return f'Thread {thread.num} ({target}):'
+
+    def frame_line(index, frame):
+        if frame.type() == gdb.SIGTRAMP_FRAME:
+            return f'#{index:<2} <signal handler called>'
+        # Inline frames share the pc of their outer frame, gdb doesn't print it for them.
+        show_address = frame.type() != gdb.INLINE_FRAME and not frame.at_statement
+        address = f'0x{frame.pc:016x} in ' if show_address else ''
+        function = str(frame.function()) if frame.function() else '??'
+        line = f'#{index:<2} {address}{function} ({frame.arguments()})'
+        if frame.filename():
+            line += f' at {frame.filename()}:{frame.line}'
+        elif frame.package():
+            line += f' from {frame.package()}'
+        return line
+
+    def print_thread(thread, frame_limit):
+        thread.switch()
+        # One more than we print so we know whether to say there is more.
+        frames = FrameCapture.frames(thread, None if frame_limit is None else frame_limit + 1)
+        print()
+        print(TextTrace.thread_header(thread))
+        for index, frame in enumerate(frames[:frame_limit]):
+            print(TextTrace.frame_line(index, frame))
+        if frame_limit is not None and len(frames) > frame_limit:
+            print('(More stack frames follow...)')
+        elif frames:
+            TextTrace.print_stop_reason(frames[-1])
+
+    def print_stop_reason(frame):
+        try:
+            reason = frame.frame.unwind_stop_reason()
+        except gdb.error:
+            return
+        if reason >= gdb.FRAME_UNWIND_FIRST_ERROR:
+            print(f'Backtrace stopped: {gdb.frame_stop_reason_string(reason)}')
+
+def print_backtraces():
+    # Equivalent of `thread apply all bt` but applying the ThreadSampling policy.
+    threads = gdb.selected_inferior().threads()
+    if not ThreadSampling.active(threads):
+        # gdb's own output is the reference (frame filters and all). Only render ourselves when we need to sample.
+        gdb.execute('thread apply all bt')
+        return
+    selected_thread = gdb.selected_thread()
+    crash_thread = crashed_thread or selected_thread
+    # Same order as `thread apply all`: newest thread first
+    for thread in sorted(threads, key=lambda thread: thread.num, reverse=True):
+        TextTrace.print_thread(thread, ThreadSampling.frame_limit(thread, crash_thread, threads))
+    if selected_thread:
+        selected_thread.switch()
+
 class GDBCoreImage:
     def __init__(self, mapped_file):
         self.valid = False
@@ -592,6 +837,25 @@ class EUUnstripCoreImage:
 
         self.valid = self.file is not None
 
+class TableCoreImage:
+    def __init__(self, entry):
+        self.file = entry.get('file')
+        self.build_id = entry.get('build_id')
+        self.address = entry.get('address')
+        self.length = entry.get('length')
+        self.valid = bool(self.file and self.build_id and self.address and self.length is not None)
+
+def resolve_modules_table(table_file):
+    global core_images
+
+    # Precomputed by drkonqi when excavating the core. Same data as gdb.Corefile or eu-unstrip would give us, without
+    # having to scan the core again.
+    with open(table_file, 'r') as f:
+        for entry in json.load(f):
+            image = TableCoreImage(entry)
+            if image.valid:
+                core_images.append(image)
+
 def resolve_modules_eu_unstrip(corefile):
     global core_images
 
@@ -620,6 +884,16 @@ def resolve_modules():
     if not corefile:
         raise RuntimeError("No corefile found. Cannot resolve modules.")
 
+    table_file = os.getenv("DRKONQI_MODULE_TABLE")
+    if table_file:
+        try:
+            resolve_modules_table(table_file)
+            print("Using module table to resolve modules.")
+            return
+        except (OSError, ValueError, AttributeError) as e:
+            print(f"Failed to load module table {table_file}: {e}")
+            core_images.clear()
+
     # I'd rather not have random name errors come out of the resolve function
     # and trip us up. Instead check specifically if gdb.Corefile exists and only
     # then run the resolve functions. Slightly more robust this way.
@@ -637,19 +911,38 @@ def resolve_modules():
         print("Using eu-unstrip to resolve modules.")
         resolve_modules_eu_unstrip(corefile)
 
+def load_core():
+    # Pipelined mode: we got started before the core was fully excavated so python and the executable's symbols
+    # could load in the meantime. Block until drkonqi tells us the core is ready, then load it.
+    fifo = os.getenv('DRKONQI_CORE_READY_FIFO')
+    if not fifo:
+        return # the core was passed on the command line
+
+    # drkonqi holds the fifo open for writing, should it go away we read EOF rather than blocking forever.
+    with open(fifo, mode='r') as pipe:
+        status = pipe.readline().strip()
+    if status != 'ready':
+        raise RuntimeError(f"Core did not become ready: '{status}'")
+
+    corefile = os.getenv('DRKONQI_COREFILE')
+    table_file = os.getenv('DRKONQI_MODULE_TABLE')
+    if table_file and not os.path.exists(table_file):
+        del os.environ['DRKONQI_MODULE_TABLE'] # excavation didn't manage to build one
+    gdb.execute('core-file "{}"'.format(corefile.replace('\\', '\\\\').replace('"', '\\"')))
+
 def print_preamble_internal():
+    load_core()
     resolve_modules()
 
     thread = gdb.selected_thread()
     if thread == None:
         # Can happen when e.g. the core is missing or not readable etc. We basically aren't debugging anything
         return
-    if 'sentry_sdk' in globals():
-        sentry_sdk.add_breadcrumb(
-            category='debug',
-            level='debug',
-            message=f'Selected thread {thread}',
-        )
+    Sentry.add_breadcrumb(
+        category='debug',
+        level='debug',
+        message=f'Selected thread {thread}',
+    )
     global crashed_thread
     crashed_thread = thread
     # run this first as it expects the current frame to be the crashing one and further tracing changes the frames around
@@ -666,8 +959,7 @@ def print_preamble():
     try:
         print_preamble_internal()
     except Exception as e:
-        if 'sentry_sdk' in globals():
-            sentry_sdk.capture_exception(e)
+        Sentry.capture_exception(e)
         traceback.print_exc()
         print(e)
         gdb.execute('quit 1')
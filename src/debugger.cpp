@@ -29,6 +29,9 @@ QList<Debugger> Debugger::availableInternalDebuggers(const QString &backend)
         };
         return KMacroExpander::expandMacros(command, map);
     };
+    // print_backtraces comes from the preamble. Should that have failed to load we still want a plain trace.
+    const auto gdbBacktraceCommands =
+        u"thread\npython\ntry:\n    print_backtraces()\nexcept Exception:\n    gdb.execute('thread apply all bt')\nend"_s;
 
     if (backend == "KCrash"_L1) {
         result.push_back(std::make_shared<Data>(
@@ -40,7 +43,7 @@ QList<Debugger> Debugger::availableInternalDebuggers(const QString &backend)
                                  .supportsCommandWithSymbolResolution = true,
                                  .commandWithSymbolResolution =
                                      u"gdb -nw -n -batch --init-eval-command='set debuginfod enabled on' -x %preamblefile -x %tempfile -p %pid %execpath"_s,
-                                 .backtraceBatchCommands = u"thread\nthread apply all bt"_s,
+                                 .backtraceBatchCommands = gdbBacktraceCommands,
                                  .preambleCommands = expandCommand(
                                      u"gdb"_s,
                                      u"set width 200\nset backtrace limit 128\nsource %drkonqi_datadir/python/gdb_preamble/preamble.py\npy print_preamble()"_s),
@@ -67,11 +70,14 @@ QList<Debugger> Debugger::availableInternalDebuggers(const QString &backend)
                     .supportsCommandWithSymbolResolution = true,
                     .commandWithSymbolResolution =
                         u"gdb --nw --nx --batch --init-eval-command='set debuginfod enabled on' --command=%preamblefile --command=%tempfile --core=%corefile %execpath"_s,
-                    .backtraceBatchCommands = u"thread\nthread apply all bt"_s,
+                    .backtraceBatchCommands = gdbBacktraceCommands,
                     .preambleCommands = expandCommand(
                         u"gdb"_s,
                         u"set width 200\nset backtrace limit 128\nsource %drkonqi_datadir/python/gdb_preamble/preamble.py\npy print_preamble()"_s),
-                    .execInputFile = {}}}));
+                    .execInputFile = {},
+                    .pipelinedCommand = u"gdb --nw --nx --batch --command=%preamblefile --command=%tempfile %execpath"_s,
+                    .pipelinedCommandWithSymbolResolution =
+                        u"gdb --nw --nx --batch --init-eval-command='set debuginfod enabled on' --command=%preamblefile --command=%tempfile %execpath"_s}}));
     }
 
     return result;
@@ -194,6 +200,21 @@ QString Debugger::execInputFile() const
     return m_data->backendData->execInputFile;
 }
 
+bool Debugger::supportsPipelinedCore() const
+{
+    return !m_data->backendData->pipelinedCommand.isEmpty();
+}
+
+QString Debugger::pipelinedCommand() const
+{
+    return m_data->backendData->pipelinedCommand;
+}
+
+QString Debugger::pipelinedCommandWithSymbolResolution() const
+{
+    return m_data->backendData->pipelinedCommandWithSymbolResolution;
+}
+
 Debugger::Debugger(const std::shared_ptr<Data> &data)
     : m_data(data)
 {
@@ -61,6 +61,15 @@ public:
 
     [[nodiscard]] QString execInputFile() const;
 
+    /// Supports starting before the core is ready. The debugger then waits for DRKONQI_CORE_READY_FIFO and loads the core itself.
+    [[nodiscard]] bool supportsPipelinedCore() const;
+
+    /** Returns the command that should be run to use the debugger when the core is not yet ready */
+    [[nodiscard]] QString pipelinedCommand() const;
+
+    /** Returns the pipelined command with symbol resolution enabled */
+    [[nodiscard]] QString pipelinedCommandWithSymbolResolution() const;
+
     enum ExpandStringUsage {
         ExpansionUsagePlainText,
         ExpansionUsageShell,
@@ -82,6 +91,9 @@ private:
         QString preambleCommands;
         // FIXME this is only used by lldb and wholly pointless because lldb supports better interaction systems
         QString execInputFile;
+        // Same as command but without the core, only set when the debugger supports being pipelined.
+        QString pipelinedCommand = {};
+        QString pipelinedCommandWithSymbolResolution = {};
     };
 
     struct Data {
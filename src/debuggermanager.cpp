@@ -26,6 +26,7 @@ DebuggerManager::DebuggerManager(const Debugger &internalDebugger, AbstractDrKon
     connect(d->btGenerator, &BacktraceGenerator::failedToStart, this, &DebuggerManager::onDebuggerFinished);
     connect(d->btGenerator, &BacktraceGenerator::preparing, backendParent, &AbstractDrKonqiBackend::prepareForDebugger);
     connect(backendParent, &AbstractDrKonqiBackend::failedToPrepare, d->btGenerator, &BacktraceGenerator::setBackendFailedToPrepare);
+    connect(backendParent, &AbstractDrKonqiBackend::pipelinedForDebugger, d->btGenerator, &BacktraceGenerator::setBackendPipelined);
     connect(backendParent, &AbstractDrKonqiBackend::preparedForDebugger, d->btGenerator, &BacktraceGenerator::setBackendPrepared);
 }
 
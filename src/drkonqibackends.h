@@ -34,6 +34,8 @@ public:
     static QString metadataPath();
 
 Q_SIGNALS:
+    // Optional. The debugger may already start, the core follows with preparedForDebugger (or failedToPrepare).
+    void pipelinedForDebugger();
     void preparedForDebugger();
     void failedToPrepare(const QString &context);
 
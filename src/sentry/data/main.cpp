@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: 2023 Harald Sitter <sitter@kde.org>
 
 // Collects various data into a json blob for use in the sentry payloads.
+// NOTE: drkonqi usually passes this data along via DRKONQI_SYSTEM_FACTS. This is only the fallback when it didn't have the data ready.
 
 #include <chrono>
 #include <iostream>
@@ -14,6 +14,8 @@
 
 #include <KMemoryInfo>
 
+#include <coreplacement.h>
+
 #include "drkonqi_debug.h"
 
 #include "managerinterface.h"
@@ -72,7 +74,8 @@ std::optional<qulonglong> MemoryFence::freeRAM()
     if (info.isNull()) {
         return {};
     }
-    return info.freePhysical() + info.buffers() + info.cached();
+    const auto cached = info.cached();
+    return info.freePhysical() + info.buffers() + cached - std::min<qulonglong>(cached, CorePlacement::memoryUsage());
 }
 
 void MemoryFence::getMemory()
@@ -121,7 +124,7 @@ void MemoryFence::applyProperties(qulonglong memoryCurrent, qulonglong memoryAva
     const auto memoryAvailableGiB = memoryAvailable / GiB;
     qWarning() << "Available memory (GiB):" << memoryAvailableGiB;
 
-    constexpr auto lotsGiB = 12;
+    constexpr auto lotsGiB = 12; // CorePlacement's SPACIOUS_FREE_RAM depends on this and the breathing room above
     constexpr auto someGiB = 4;
     constexpr auto littleGiB = 2;
     if (memoryAvailableGiB > lotsGiB) {
@@ -24,6 +24,8 @@ public:
 
     void surroundMe();
     [[nodiscard]] Size size() const;
+    // Reclaimable memory, minus cores placed in memory (they look like cache but can't be reclaimed).
+    [[nodiscard]] static std::optional<qulonglong> freeRAM();
 
 Q_SIGNALS:
     void loaded();
@@ -32,7 +34,6 @@ Q_SIGNALS:
 private:
     bool registerDBusTypes();
     void getUnit();
-    [[nodiscard]] std::optional<qulonglong> freeRAM();
     void getMemory();
     void applyProperties(qulonglong memoryCurrent, qulonglong memoryAvailable);
 
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "systemfacts.h"
+
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KMemoryInfo>
+
+#include "drkonqi_debug.h"
+
+#include "propertiesinterface.h"
+
+using namespace Qt::StringLiterals;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto BOOT_ID_KEY = "BootId"_L1;
+constexpr auto WRITTEN_KEY = "Written"_L1;
+constexpr auto VIRTUALIZATION_KEY = "Virtualization"_L1;
+} // namespace
+
+SystemFacts::Config::Config()
+    : cachePath(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/drkonqi/system-facts.json"_L1)
+    , bootIdPath(u"/proc/sys/kernel/random/boot_id"_s)
+    , cpuInfoPath(u"/proc/cpuinfo"_s)
+    , timeToLive(std::chrono::hours(24))
+{
+}
+
+SystemFacts::SystemFacts(Config config, QObject *parent)
+    : QObject(parent)
+    , m_config(std::move(config))
+{
+}
+
+void SystemFacts::gather()
+{
+    if (m_complete || m_gathering) {
+        return;
+    }
+
+    if (loadCache()) {
+        qCDebug(DRKONQI_LOG) << "Using cached system facts" << m_config.cachePath;
+        m_complete = true;
+        Q_EMIT gathered();
+        return;
+    }
+
+    m_gathering = true;
+    m_incomplete = false;
+    m_facts = {};
+    m_facts.insert(u"CpuModel"_s, cpuModel());
+    if (const auto time = bootTime(); time.isValid()) {
+        m_facts.insert(u"BootTime"_s, time.toUTC().toString(u"yyyy-MM-dd'T'HH:mm:ss"_s));
+    }
+
+    // All calls run in parallel, we are done when the last one returns.
+    m_pendingCalls = 4;
+    getProperty(m_config.systemBus, u"org.freedesktop.hostname1"_s, u"/org/freedesktop/hostname1"_s, u"org.freedesktop.hostname1"_s, u"Hostname"_s);
+    getProperty(m_config.systemBus, u"org.freedesktop.hostname1"_s, u"/org/freedesktop/hostname1"_s, u"org.freedesktop.hostname1"_s, u"Chassis"_s);
+    getProperty(m_config.sessionBus,
+                u"org.freedesktop.systemd1"_s,
+                u"/org/freedesktop/systemd1"_s,
+                u"org.freedesktop.systemd1.Manager"_s,
+                VIRTUALIZATION_KEY);
+    getProperty(m_config.systemBus, u"org.freedesktop.timedate1"_s, u"/org/freedesktop/timedate1"_s, u"org.freedesktop.timedate1"_s, u"Timezone"_s);
+}
+
+bool SystemFacts::isComplete() const
+{
+    return m_complete;
+}
+
+QJsonObject SystemFacts::facts() const
+{
+    return m_facts;
+}
+
+QHash<QString, QString> SystemFacts::environment() const
+{
+    if (!m_complete) {
+        return {};
+    }
+
+    auto facts = m_facts;
+    facts.remove(BOOT_ID_KEY);
+    facts.remove(WRITTEN_KEY);
+    // Memory is the one thing that isn't static. Fill it in freshly.
+    if (KMemoryInfo info; !info.isNull()) {
+        facts.insert(u"MemorySize"_s, static_cast<qint64>(info.totalPhysical()));
+        facts.insert(u"FreeMemory"_s, static_cast<qint64>(info.availablePhysical()));
+    }
+    return {{u"DRKONQI_SYSTEM_FACTS"_s, QString::fromUtf8(QJsonDocument(facts).toJson(QJsonDocument::Compact))}};
+}
+
+QByteArray SystemFacts::bootId() const
+{
+    QFile file(m_config.bootIdPath);
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(DRKONQI_LOG) << "Failed to read boot id" << m_config.bootIdPath << file.errorString();
+        return {};
+    }
+    return file.readAll().trimmed();
+}
+
+QString SystemFacts::cpuModel() const
+{
+    QFile file(m_config.cpuInfoPath);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    while (!file.atEnd()) {
+        const auto line = file.readLine();
+        const auto separator = line.indexOf(':');
+        if (separator < 0) {
+            continue;
+        }
+        const auto key = line.left(separator).trimmed();
+        if (key == "model name"_ba || key == "model"_ba) { // on arm64 this is just 'model'
+            return QString::fromUtf8(line.mid(separator + 1).trimmed());
+        }
+    }
+    return {};
+}
+
+QDateTime SystemFacts::bootTime() const
+{
+    QFile file(u"/proc/stat"_s);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    while (!file.atEnd()) {
+        const auto line = file.readLine();
+        if (line.startsWith("btime "_ba)) {
+            bool ok = false;
+            const auto seconds = line.mid(6).trimmed().toLongLong(&ok);
+            return ok ? QDateTime::fromSecsSinceEpoch(seconds) : QDateTime();
+        }
+    }
+    return {};
+}
+
+bool SystemFacts::loadCache()
+{
+    const auto currentBootId = bootId();
+    if (currentBootId.isEmpty()) {
+        return false;
+    }
+
+    QFile file(m_config.cachePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    const auto facts = QJsonDocument::fromJson(file.readAll()).object();
+    if (facts.value(BOOT_ID_KEY).toString() != QString::fromUtf8(currentBootId)) {
+        qCDebug(DRKONQI_LOG) << "System facts cache is from another boot";
+        return false;
+    }
+
+    const auto written = QDateTime::fromSecsSinceEpoch(facts.value(WRITTEN_KEY).toInteger());
+    const auto age = std::chrono::seconds(written.secsTo(QDateTime::currentDateTimeUtc()));
+    if (age < 0s || age > m_config.timeToLive) {
+        qCDebug(DRKONQI_LOG) << "System facts cache is stale" << age;
+        return false;
+    }
+
+    m_facts = facts;
+    return true;
+}
+
+void SystemFacts::writeCache()
+{
+    const auto currentBootId = bootId();
+    if (currentBootId.isEmpty()) {
+        return; // would never be valid anyway
+    }
+
+    auto facts = m_facts;
+    facts.insert(BOOT_ID_KEY, QString::fromUtf8(currentBootId));
+    facts.insert(WRITTEN_KEY, QDateTime::currentSecsSinceEpoch());
+
+    QDir().mkpath(QFileInfo(m_config.cachePath).path());
+    QSaveFile file(m_config.cachePath);
+    if (!file.open(QFile::WriteOnly)) {
+        qCWarning(DRKONQI_LOG) << "Failed to open system facts cache for writing" << m_config.cachePath << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(facts).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(DRKONQI_LOG) << "Failed to write system facts cache" << m_config.cachePath << file.errorString();
+    }
+}
+
+void SystemFacts::getProperty(const QDBusConnection &bus, const QString &service, const QString &path, const QString &interface, const QString &property)
+{
+    OrgFreedesktopDBusPropertiesInterface properties{service, path, bus};
+    properties.setTimeout(static_cast<int>(std::chrono::milliseconds(4s).count())); // arbitrarily low timeout
+    auto watcher = new QDBusPendingCallWatcher(properties.Get(interface, property), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, property] {
+        watcher->deleteLater();
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(DRKONQI_LOG) << "Failed to get system fact" << property << reply.error();
+            m_incomplete = true;
+        } else {
+            m_facts.insert(property, QJsonValue::fromVariant(reply.value().variant()));
+        }
+        finishOne();
+    });
+}
+
+void SystemFacts::finishOne()
+{
+    if (--m_pendingCalls > 0) {
+        return;
+    }
+
+    // Convert to bool. The preamble only cares whether we are virtualized, not how.
+    m_facts.insert(VIRTUALIZATION_KEY, !m_facts.value(VIRTUALIZATION_KEY).toString().isEmpty());
+
+    m_gathering = false;
+    m_complete = true;
+    if (!m_incomplete) { // don't persist partial data, we'll want to try again next time
+        writeCache();
+    }
+    Q_EMIT gathered();
+}
+
+#include "moc_systemfacts.cpp"
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <chrono>
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QObject>
+
+// Mostly static facts about the system that end up in the sentry payload (hostname, chassis, etc.).
+// They are gathered asynchronously from systemd's D-Bus services and cached on disk for the current boot, so
+// the gdb preamble can simply pick them up from its environment instead of having to ask the system bus.
+class SystemFacts : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config {
+        Config();
+
+        // Where to persist the facts
+        QString cachePath;
+        // Path to the boot_id file. The cache is only valid for the boot it was written in.
+        QString bootIdPath;
+        // Path to the cpuinfo file
+        QString cpuInfoPath;
+        // Maximum age of the cache. Hostnames and timezones may change without a reboot after all.
+        std::chrono::seconds timeToLive;
+        QDBusConnection systemBus = QDBusConnection::systemBus();
+        QDBusConnection sessionBus = QDBusConnection::sessionBus();
+    };
+
+    explicit SystemFacts(Config config = Config(), QObject *parent = nullptr);
+
+    // Starts gathering. Emits gathered() when done, possibly before returning when the cache is usable.
+    void gather();
+    /// All facts gathered (or failed to be gathered)
+    [[nodiscard]] bool isComplete() const;
+    [[nodiscard]] QJsonObject facts() const;
+    // Environment to pass into the debugger. Empty when not complete.
+    [[nodiscard]] QHash<QString, QString> environment() const;
+
+Q_SIGNALS:
+    void gathered();
+
+private:
+    [[nodiscard]] QByteArray bootId() const;
+    [[nodiscard]] QString cpuModel() const;
+    [[nodiscard]] QDateTime bootTime() const;
+    [[nodiscard]] bool loadCache();
+    void writeCache();
+    void getProperty(const QDBusConnection &bus, const QString &service, const QString &path, const QString &interface, const QString &property);
+    void finishOne();
+
+    Config m_config;
+    QJsonObject m_facts;
+    int m_pendingCalls = 0;
+    bool m_gathering = false;
+    bool m_incomplete = false;
+    bool m_complete = false;
+};
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+// Measures how long native excavation of a synthetic multi-gigabyte zstd core takes, once as a single frame (as
+// systemd-coredump writes it) and once split into many frames (which get decompressed in parallel).
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <zstd.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <nativeexcavator.h>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+constexpr qint64 CHUNK_SIZE = 1024 * 1024;
+
+// Roughly what a core of a big process looks like: lots of zero pages, some fairly compressible data, some noise.
+void fillChunk(QByteArray &chunk, qint64 index)
+{
+    chunk.resize(CHUNK_SIZE);
+    auto state = quint64(index) * 0x9E3779B97F4A7C15ULL + 1;
+    auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    switch (index % 3) {
+    case 0:
+        chunk.fill('\0');
+        break;
+    case 1:
+        for (qint64 i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i] = char("QQmlEngine QObject QString "[i % 27]);
+        }
+        for (int i = 0; i < 1024; ++i) {
+            chunk[qsizetype(next() % CHUNK_SIZE)] = char(next());
+        }
+        break;
+    case 2:
+        for (qint64 i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i] = char(next() & 0x0F);
+        }
+        break;
+    }
+}
+
+struct Compressed {
+    QString path;
+    QByteArray sha256;
+};
+
+// Writes the synthetic core compressed. frameSize 0 means a single frame.
+Compressed compress(const QString &path, qint64 size, qint64 frameSize)
+{
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, 1);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_nbWorkers, 4); // only speeds up generation, may fail without MT support
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        qFatal("Failed to open %s", qPrintable(path));
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray chunk;
+    QByteArray output(qsizetype(ZSTD_CStreamOutSize()), Qt::Uninitialized);
+    const qint64 chunks = size / CHUNK_SIZE;
+    const qint64 chunksPerFrame = frameSize > 0 ? frameSize / CHUNK_SIZE : chunks;
+    for (qint64 index = 0; index < chunks; ++index) {
+        fillChunk(chunk, index);
+        hash.addData(chunk);
+        const bool endOfFrame = (index + 1) % chunksPerFrame == 0 || index + 1 == chunks;
+        if ((index % chunksPerFrame) == 0) {
+            // Frames declare their content size so the excavator knows where they go
+            const qint64 thisFrame = std::min(chunksPerFrame, chunks - index) * CHUNK_SIZE;
+            ZSTD_CCtx_setPledgedSrcSize(context.get(), quint64(thisFrame));
+        }
+        ZSTD_inBuffer in{.src = chunk.constData(), .size = size_t(chunk.size()), .pos = 0};
+        const auto mode = endOfFrame ? ZSTD_e_end : ZSTD_e_continue;
+        size_t remaining = 0;
+        do {
+            ZSTD_outBuffer out{.dst = output.data(), .size = size_t(output.size()), .pos = 0};
+            remaining = ZSTD_compressStream2(context.get(), &out, &in, mode);
+            if (ZSTD_isError(remaining)) {
+                qFatal("Failed to compress: %s", ZSTD_getErrorName(remaining));
+            }
+            file.write(output.constData(), qint64(out.pos));
+        } while (endOfFrame ? remaining != 0 : in.pos < in.size);
+    }
+    return {.path = path, .sha256 = hash.result()};
+}
+
+QJsonObject measure(const Compressed &compressed, const QString &targetPath, int runs)
+{
+    QList<double> durations;
+    for (int run = 0; run < runs; ++run) {
+        QFile::remove(targetPath);
+        const int fd = open(QFile::encodeName(targetPath).constData(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = NativeExcavator::excavate(compressed.path, fd);
+        durations.append(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        close(fd);
+        if (result != NativeExcavator::Result::Excavated) {
+            qFatal("Excavation of %s failed", qPrintable(compressed.path));
+        }
+    }
+
+    QFile target(targetPath);
+    if (!target.open(QFile::ReadOnly)) {
+        qFatal("Failed to read back %s", qPrintable(targetPath));
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&target);
+    if (hash.result() != compressed.sha256) {
+        qFatal("Excavated core of %s does not match", qPrintable(compressed.path));
+    }
+
+    std::ranges::sort(durations);
+    return {
+        {u"compressed_bytes"_s, QFileInfo(compressed.path).size()},
+        {u"median_ms"_s, durations.at(durations.size() / 2)},
+        {u"min_ms"_s, durations.constFirst()},
+    };
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption sizeOption(u"size"_s, u"Size of the synthetic core in GiB"_s, u"GiB"_s, u"4"_s);
+    parser.addOption(sizeOption);
+    QCommandLineOption frameOption(u"frame-size"_s, u"Size of frames in the multi-frame core in MiB"_s, u"MiB"_s, u"64"_s);
+    parser.addOption(frameOption);
+    QCommandLineOption runsOption(u"runs"_s, u"Number of runs per variant"_s, u"runs"_s, u"3"_s);
+    parser.addOption(runsOption);
+    QCommandLineOption outputOption(u"output"_s, u"Write results as JSON to this file"_s, u"file"_s);
+    parser.addOption(outputOption);
+    QCommandLineOption directoryOption(u"directory"_s, u"Where to put the (large!) files"_s, u"directory"_s);
+    parser.addOption(directoryOption);
+    parser.process(app);
+
+    const qint64 size = parser.value(sizeOption).toLongLong() * 1024 * 1024 * 1024;
+    const qint64 frameSize = std::max<qint64>(parser.value(frameOption).toLongLong(), 1) * 1024 * 1024;
+    const int runs = std::max(parser.value(runsOption).toInt(), 1);
+
+    QTemporaryDir dir(parser.isSet(directoryOption) ? parser.value(directoryOption) + u"/excavation-benchmark-XXXXXX"_s : QString());
+    if (!dir.isValid()) {
+        qFatal("Failed to create temporary directory");
+    }
+
+    std::cout << "Generating " << size / (1024 * 1024) << " MiB core..." << std::endl;
+    const auto singleFrame = compress(dir.filePath(u"single.zst"_s), size, 0);
+    const auto multiFrame = compress(dir.filePath(u"multi.zst"_s), size, frameSize);
+
+    QJsonObject results{
+        {u"size_bytes"_s, size},
+        {u"single_frame"_s, measure(singleFrame, dir.filePath(u"core"_s), runs)},
+        {u"multi_frame"_s, measure(multiFrame, dir.filePath(u"core"_s), runs)},
+    };
+    std::cout << "single frame: " << results[u"single_frame"_s].toObject()[u"median_ms"_s].toDouble() << " ms\n"
+              << " multi frame: " << results[u"multi_frame"_s].toObject()[u"median_ms"_s].toDouble() << " ms\n";
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QFile::WriteOnly)) {
+            qFatal("Failed to write %s", qPrintable(output.fileName()));
+        }
+        output.write(QJsonDocument(results).toJson());
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+# SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+# Measures how long it takes from spawning gdb until the preamble prints its first line, for every memory tier.
+# This is the latency users stare at before anything shows up in the backtrace view, track it for regressions.
+# With --excavation-delay the core additionally takes that long to "excavate" and gdb is started either after it
+# (serial) or right away, waiting on the core ready fifo (pipelined). The difference is what pipelining saves.
+
+import argparse
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+TIERS = ['cramped', 'little', 'some', 'spacious']
+LOADED_MARKER = 'DRKONQI-BENCHMARK-PREAMBLE-LOADED'
+
+def make_core(gdb, workdir):
+    victim = subprocess.Popen(['sleep', '600'])
+    try:
+        core = os.path.join(workdir, 'core')
+        subprocess.run([gdb, '--nx', '--batch', '-p', str(victim.pid), '-ex', f'gcore {core}'],
+                       check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        return core, shutil.which('sleep')
+    finally:
+        victim.kill()
+        victim.wait()
+
+def write_commands(workdir, preamble):
+    path = os.path.join(workdir, 'commands')
+    with open(path, 'w') as f:
+        f.write('set width 200\n')
+        f.write('set backtrace limit 128\n')
+        f.write(f'source {preamble}\n')
+        # Never report exceptions from benchmark runs.
+        f.write('py Sentry.capture_exception = lambda exception: None\n')
+        f.write(f'echo {LOADED_MARKER}\\n\n')
+        f.write('py print_preamble()\n')
+    return path
+
+def measure(gdb, commands, core, executable, tier, excavation_delay=0, pipelined=False):
+    env = os.environ.copy()
+    env.update({
+        'DRKONQI_MEMORY': tier,
+        'DRKONQI_COREFILE': core,
+        'DRKONQI_VERSION': 'benchmark',
+        'DRKONQI_SIGNAL': '11',
+    })
+    env.pop('DEBUGINFOD_URLS', None)
+
+    arguments = [gdb, '--nw', '--nx', '--batch', f'--command={commands}']
+    fifo = None
+    fifo_fd = None
+    if pipelined:
+        fifo = os.path.join(os.path.dirname(commands), 'core-ready')
+        os.mkfifo(fifo)
+        fifo_fd = os.open(fifo, os.O_RDWR | os.O_NONBLOCK)
+        env['DRKONQI_CORE_READY_FIFO'] = fifo
+    else:
+        arguments.append(f'--core={core}')
+    arguments.append(executable)
+
+    start = time.monotonic()
+    if not pipelined:
+        time.sleep(excavation_delay)
+    proc = subprocess.Popen(arguments, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, env=env, text=True)
+    if pipelined:
+        # Same as drkonqi: the debugger starts right away, the core follows once excavated.
+        time.sleep(excavation_delay)
+        os.write(fifo_fd, b'ready\n')
+    loaded = None
+    first_line = None
+    try:
+        for line in proc.stdout:
+            if loaded is None:
+                if line.startswith(LOADED_MARKER):
+                    loaded = time.monotonic() - start
+                continue
+            first_line = time.monotonic() - start
+            break
+    finally:
+        proc.kill()
+        proc.wait()
+        if fifo:
+            os.close(fifo_fd)
+            os.unlink(fifo)
+
+    if loaded is None or first_line is None:
+        raise RuntimeError(f'gdb never printed anything from the preamble (tier {tier})')
+    return loaded, first_line
+
+def main():
+    parser = argparse.ArgumentParser(description='gdb+preamble cold start benchmark')
+    parser.add_argument('--gdb', default=shutil.which('gdb'))
+    parser.add_argument('--preamble', required=True)
+    parser.add_argument('--runs', type=int, default=10)
+    parser.add_argument('--excavation-delay', type=int, default=0, help='simulated excavation time in ms; compares serial and pipelined startup')
+    parser.add_argument('--output', help='write results as JSON to this file')
+    args = parser.parse_args()
+
+    if not args.gdb:
+        print('gdb not found', file=sys.stderr)
+        return 1
+
+    results = {}
+    with tempfile.TemporaryDirectory() as workdir:
+        core, executable = make_core(args.gdb, workdir)
+        commands = write_commands(workdir, os.path.abspath(args.preamble))
+        for tier in TIERS:
+            # The first run is the cold one (or as cold as we can get it without dropping the page cache).
+            cold_loaded, cold_first_line = measure(args.gdb, commands, core, executable, tier)
+            runs = [measure(args.gdb, commands, core, executable, tier) for _ in range(max(args.runs, 1))]
+            results[tier] = {
+                'cold_loaded_ms': round(cold_loaded * 1000, 1),
+                'cold_first_line_ms': round(cold_first_line * 1000, 1),
+                'loaded_ms': round(statistics.median(run[0] for run in runs) * 1000, 1),
+                'first_line_ms': round(statistics.median(run[1] for run in runs) * 1000, 1),
+            }
+            print(f"{tier:>10}: cold {results[tier]['cold_first_line_ms']:8.1f} ms"
+                  f"  median {results[tier]['first_line_ms']:8.1f} ms"
+                  f"  (preamble loaded after {results[tier]['loaded_ms']:.1f} ms)")
+
+            if args.excavation_delay > 0:
+                delay = args.excavation_delay / 1000
+                serial = statistics.median(measure(args.gdb, commands, core, executable, tier, delay)[1] for _ in range(max(args.runs, 1)))
+                pipelined = statistics.median(measure(args.gdb, commands, core, executable, tier, delay, pipelined=True)[1]
+                                              for _ in range(max(args.runs, 1)))
+                results[tier]['serial_first_line_ms'] = round(serial * 1000, 1)
+                results[tier]['pipelined_first_line_ms'] = round(pipelined * 1000, 1)
+                print(f"{'':>10}  with {args.excavation_delay} ms excavation: serial {serial * 1000:8.1f} ms"
+                      f"  pipelined {pipelined * 1000:8.1f} ms  (saves {(serial - pipelined) * 1000:.1f} ms)")
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(results, f, indent=2)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,246 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+    SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+*/
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopeGuard>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <systemd/systemfacts.h>
+
+// Stand-ins for the systemd services. Only their properties are of interest.
+class FakeHostname : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.hostname1")
+    Q_PROPERTY(QString Hostname READ hostname CONSTANT)
+    Q_PROPERTY(QString Chassis READ chassis CONSTANT)
+public:
+    using QObject::QObject;
+    [[nodiscard]] QString hostname() const
+    {
+        return "kde-neon";
+    }
+    [[nodiscard]] QString chassis() const
+    {
+        return "laptop";
+    }
+};
+
+class FakeTimedate : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.timedate1")
+    Q_PROPERTY(QString Timezone READ timezone CONSTANT)
+public:
+    using QObject::QObject;
+    [[nodiscard]] QString timezone() const
+    {
+        return "Europe/Vienna";
+    }
+};
+
+class FakeManager : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.systemd1.Manager")
+    Q_PROPERTY(QString Virtualization READ virtualization CONSTANT)
+public:
+    using QObject::QObject;
+    [[nodiscard]] QString virtualization() const
+    {
+        return "kvm";
+    }
+};
+
+class SystemFactsTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir m_dir;
+
+    [[nodiscard]] SystemFacts::Config config()
+    {
+        SystemFacts::Config config;
+        config.cachePath = m_dir.filePath("system-facts.json");
+        config.bootIdPath = m_dir.filePath("boot_id");
+        config.cpuInfoPath = m_dir.filePath("cpuinfo");
+        return config;
+    }
+
+    // Every call fails, so a gather that doesn't use the cache finishes incomplete.
+    [[nodiscard]] SystemFacts::Config disconnectedConfig()
+    {
+        auto config = this->config();
+        config.systemBus = QDBusConnection("systemfactstest-disconnected");
+        config.sessionBus = config.systemBus;
+        return config;
+    }
+
+    [[nodiscard]] QJsonObject readCache()
+    {
+        QFile file(m_dir.filePath("system-facts.json"));
+        if (!file.open(QFile::ReadOnly)) {
+            return {};
+        }
+        return QJsonDocument::fromJson(file.readAll()).object();
+    }
+
+    // Writes a cache file the way SystemFacts would.
+    void writeCache(const QString &bootId, qint64 written)
+    {
+        const QJsonObject cache{
+            {"BootId", bootId},
+            {"Written", written},
+            {"Hostname", "kde-neon"},
+            {"Chassis", "laptop"},
+            {"Virtualization", false},
+            {"Timezone", "Europe/Vienna"},
+            {"CpuModel", "Konqi CPU @ 4.20GHz"},
+        };
+        write(m_dir.filePath("system-facts.json"), QJsonDocument(cache).toJson());
+    }
+
+    static void write(const QString &path, const QByteArray &data)
+    {
+        QFile file(path);
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+        file.write(data);
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+        write(m_dir.filePath("boot_id"), "1c3e8c0b-6c33-4f0c-9d46-7d3c2c1e4b07\n");
+        write(m_dir.filePath("cpuinfo"), "processor\t: 0\nmodel name\t: Konqi CPU @ 4.20GHz\n");
+    }
+
+    void init()
+    {
+        QFile::remove(m_dir.filePath("system-facts.json"));
+    }
+
+    void testCacheHit()
+    {
+        writeCache("1c3e8c0b-6c33-4f0c-9d46-7d3c2c1e4b07", QDateTime::currentSecsSinceEpoch());
+
+        SystemFacts facts(config());
+        QSignalSpy spy(&facts, &SystemFacts::gathered);
+        facts.gather();
+        // Cache hits are synchronous.
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(facts.isComplete());
+        QCOMPARE(facts.facts().value("Hostname").toString(), "kde-neon");
+
+        const auto environment = facts.environment();
+        QVERIFY(environment.contains("DRKONQI_SYSTEM_FACTS"));
+        const auto object = QJsonDocument::fromJson(environment.value("DRKONQI_SYSTEM_FACTS").toUtf8()).object();
+        QCOMPARE(object.value("Timezone").toString(), "Europe/Vienna");
+        QCOMPARE(object.value("CpuModel").toString(), "Konqi CPU @ 4.20GHz");
+        QVERIFY(!object.contains("BootId"));
+        QVERIFY(!object.contains("Written"));
+    }
+
+    void testCacheExpired()
+    {
+        const auto written = QDateTime::currentSecsSinceEpoch() - 2 * 60 * 60;
+        writeCache("1c3e8c0b-6c33-4f0c-9d46-7d3c2c1e4b07", written);
+
+        auto config = disconnectedConfig();
+        config.timeToLive = std::chrono::hours(1);
+        SystemFacts facts(config);
+        QSignalSpy spy(&facts, &SystemFacts::gathered);
+        facts.gather();
+        QCOMPARE(spy.count(), 0); // not from the cache
+        QVERIFY(spy.wait());
+        QVERIFY(facts.isComplete());
+        QVERIFY(!facts.facts().contains("Hostname"));
+        QCOMPARE(facts.facts().value("CpuModel").toString(), "Konqi CPU @ 4.20GHz");
+        // Incomplete facts don't replace the cache
+        QCOMPARE(readCache().value("Written").toInteger(), written);
+    }
+
+    void testCacheFromOtherBoot()
+    {
+        writeCache("00000000-0000-0000-0000-000000000000", QDateTime::currentSecsSinceEpoch());
+
+        SystemFacts facts(disconnectedConfig());
+        QSignalSpy spy(&facts, &SystemFacts::gathered);
+        facts.gather();
+        QCOMPARE(spy.count(), 0); // not from the cache
+        QVERIFY(spy.wait());
+        QVERIFY(facts.isComplete());
+        QVERIFY(!facts.facts().contains("Hostname"));
+        QCOMPARE(readCache().value("BootId").toString(), "00000000-0000-0000-0000-000000000000");
+    }
+
+    void testGatherFromDBus()
+    {
+        auto bus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, "systemfactstest-services");
+        if (!bus.isConnected()) {
+            QSKIP("No session bus");
+        }
+        auto cleanup = qScopeGuard([] {
+            QDBusConnection::disconnectFromBus("systemfactstest-services");
+        });
+        // Everything lives on the session bus here, so make sure we don't talk to the user's systemd.
+        for (const auto &service : {"org.freedesktop.hostname1", "org.freedesktop.timedate1", "org.freedesktop.systemd1"}) {
+            if (!bus.registerService(service)) {
+                QSKIP(qPrintable(QString::fromLatin1(service) + " is already on the session bus"));
+            }
+        }
+        FakeHostname hostname;
+        FakeTimedate timedate;
+        FakeManager manager;
+        QVERIFY(bus.registerObject("/org/freedesktop/hostname1", &hostname, QDBusConnection::ExportAllProperties));
+        QVERIFY(bus.registerObject("/org/freedesktop/timedate1", &timedate, QDBusConnection::ExportAllProperties));
+        QVERIFY(bus.registerObject("/org/freedesktop/systemd1", &manager, QDBusConnection::ExportAllProperties));
+
+        auto config = this->config();
+        config.systemBus = QDBusConnection::sessionBus();
+        config.sessionBus = QDBusConnection::sessionBus();
+        {
+            SystemFacts facts(config);
+            QSignalSpy spy(&facts, &SystemFacts::gathered);
+            facts.gather();
+            QVERIFY(spy.wait());
+            QVERIFY(facts.isComplete());
+            const auto gathered = facts.facts();
+            QCOMPARE(gathered.value("Hostname").toString(), "kde-neon");
+            QCOMPARE(gathered.value("Chassis").toString(), "laptop");
+            QCOMPARE(gathered.value("Timezone").toString(), "Europe/Vienna");
+            QCOMPARE(gathered.value("Virtualization").toBool(), true);
+            QCOMPARE(gathered.value("CpuModel").toString(), "Konqi CPU @ 4.20GHz");
+        }
+
+        // Complete facts get cached for this boot
+        const auto cache = readCache();
+        QCOMPARE(cache.value("BootId").toString(), "1c3e8c0b-6c33-4f0c-9d46-7d3c2c1e4b07");
+        QCOMPARE(cache.value("Hostname").toString(), "kde-neon");
+
+        // ...and are used the next time around, without asking the bus.
+        SystemFacts facts(disconnectedConfig());
+        QSignalSpy spy(&facts, &SystemFacts::gathered);
+        facts.gather();
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(facts.facts().value("Hostname").toString(), "kde-neon");
+    }
+
+    void testIncompleteHasNoEnvironment()
+    {
+        SystemFacts facts(config());
+        QVERIFY(!facts.isComplete());
+        QVERIFY(facts.environment().isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(SystemFactsTest)
+
+#include "systemfactstest.moc"